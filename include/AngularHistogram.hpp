@@ -0,0 +1,36 @@
+#pragma once
+#include "Ray.hpp"
+#include "SmallPrimes.hpp"
+using namespace std;
+
+// Count the Gaussian primes of the first octant below the diagonal with
+// x1 <= norm <= x2 in nBins sectors of equal angle: bin k holds the primes
+// with k pi / 4nBins <= arg < (k + 1) pi / 4nBins. The primes are binned as the
+// sieve harvests them and are never gathered, so the window of norms can be
+// far larger than the primes in it would take in memory. The window is cut
+// into annuli of equal area, each sieved by AnnulusDonutSieve, which a pool of
+// threads takes from a shared counter, binning into histograms of their own.
+class AngularHistogram
+{
+private:
+  const uint64_t x1, x2;
+  const uint32_t nBins;
+  const bool verbose;
+  const uint32_t threads; // number of worker threads sieving annuli
+  // One of 2nBins slices of equal width in b / a; it meets bins bin and bin + 1
+  // at most, split by the ray (p, q) at angle (bin + 1) pi / 4nBins, which is
+  // held in 64 bits as its coordinates are below 2^62.
+  struct Slice
+  {
+    uint32_t bin;
+    int64_t p, q;
+  };
+  vector<Slice> slices;
+  SmallPrimes::View smallPrimes; // sorted by norm
+
+public:
+  // 0 threads uses every hardware thread
+  AngularHistogram(uint64_t, uint64_t, uint32_t, bool = true, uint32_t = 1);
+  uint32_t binOf(gint) const; // for a + bi with 0 <= b < a
+  vector<uint64_t> getCounts();
+};
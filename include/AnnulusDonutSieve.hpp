@@ -0,0 +1,29 @@
+#pragma once
+#include "BaseSieve.hpp"
+#include "Donut.hpp"
+using namespace std;
+
+// AnnulusSieve on the donut of gints coprime to 1 + i and 2 + i, compressed as
+// in OctantDonutSieve: word B of column A holds the 10 x 10 block with lower
+// left corner 10A + 10Bi. Column A - A0 only holds the words B = heightShifts[A
+// - A0], ..., so the inner disk of norm x1 is never stored.
+class AnnulusDonutSieve : public SieveTemplate<uint32_t>
+{
+private:
+  const uint64_t x1, x2;
+  uint32_t A0; // first column of words meeting the annulus
+  vector<uint32_t> heightShifts; // lowest word held in each column
+  static constexpr Donut<10> donut = Donut<10>::make(); // 32 residues in a 32-bit word
+  bool inSieveArray(gint);
+
+public:
+  AnnulusDonutSieve(uint64_t, uint64_t, bool = true);
+  void setFalse(uint32_t, uint32_t);
+  void setTrue(uint32_t, uint32_t);
+  // overriding virtual methods
+  void setSmallPrimes() override;
+  void setSieveArray() override;
+  void crossOffMultiples(gint) override;
+  void harvestBigPrimes(PrimeSink &) override;
+  uint64_t getCountBigPrimes() override;
+};
@@ -0,0 +1,33 @@
+#pragma once
+#include "BaseSieve.hpp"
+#include "Ray.hpp"
+using namespace std;
+
+// Sieve the gints of the first octant with norm in [x1, x2]. Column a of the
+// sieve array only holds b = heightShifts[a - aMin], ..., so nothing inside the
+// inner disk of norm x1 is ever stored; the annulus may lie far from the origin.
+// Given angles alpha and beta, the array instead holds the gints of the first
+// quadrant with norm in [x1, x2] and alpha <= arg < beta, as in SectorSieve.
+class AnnulusSieve : public SieveTemplate<bool>
+{
+private:
+  const uint64_t x1, x2;
+  const bool windowed; // restricted to alpha <= arg < beta rather than the octant
+  long double alpha, beta;
+  Ray alphaRay, betaRay; // integer direction vectors of the rays bounding the window
+  uint32_t aMin; // first column meeting the annulus
+  vector<uint32_t> heightShifts; // lowest b held in each column
+  bool inSieveArray(gint);
+  void crossOffLine(gint, int64_t, int64_t, int64_t);
+  void crossOffWindowMultiples(gint);
+
+public:
+  AnnulusSieve(uint64_t, uint64_t, bool = true);
+  AnnulusSieve(uint64_t, uint64_t, long double, long double, bool = true);
+  // overriding virtual methods
+  void setSmallPrimes() override;
+  void setSieveArray() override;
+  void crossOffMultiples(gint) override;
+  void harvestBigPrimes(PrimeSink &) override;
+  uint64_t getCountBigPrimes() override;
+};
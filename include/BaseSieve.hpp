@@ -1,6 +1,8 @@
 #pragma once
 #include <vector>
+#include <string>
 #include <cmath>
+#include "SieveArray.hpp"
 using namespace std;
 
 
@@ -33,6 +35,49 @@ struct gint {
 };
 
 
+// A line of multiples (a + bi)(c + di) of a bucket sieved prime a + bi, with c
+// fixed, waiting in the bucket of the piece of the sieve array which holds its
+// next multiple.
+struct BucketEntry {
+    int32_t a, b;  // the sieving prime a + bi, or an associate
+    int32_t c, d;  // cofactor c + di of its next multiple
+};
+
+
+// Receives the primes found by a sieve in chunks, so that they can be counted,
+// binned or written out without ever holding all of them in memory. A sieve
+// pushes every prime it finds; full chunks are handed to consume() and reused.
+class PrimeSink {
+protected:
+    vector<gint> chunk;
+    virtual void consume(const vector<gint>&) = 0;
+
+public:
+    static const uint32_t chunkSize = 1 << 16;
+    PrimeSink() { chunk.reserve(chunkSize); }
+    virtual ~PrimeSink() = default;
+    void push(gint g) {
+        chunk.push_back(g);
+        if (chunk.size() == chunkSize) { flush(); }
+    }
+    void flush() {
+        if (!chunk.empty()) { consume(chunk); chunk.clear(); }
+    }
+};
+
+
+// Adapts a callable taking a const vector<gint>& chunk into a PrimeSink.
+template <typename F>
+class PrimeVisitor : public PrimeSink {
+private:
+    F f;
+    void consume(const vector<gint>& primes) override { f(primes); }
+
+public:
+    explicit PrimeVisitor(F f) : f(f) {}
+};
+
+
 // Abstract base class to be used in various sieving implementations.
 class SieveBase {
 protected:
@@ -46,21 +91,29 @@ protected:
 
 public:
     explicit SieveBase(uint64_t, bool);  // constructor; will be called in derived classes
-    void setSmallPrimesFromFile();
+    void setSmallPrimesFromFile(const string&);
     void setSmallPrimesFromReference(const vector<gint>&);
-    void sieve();  // crossing off all multiples of small primes
+    virtual void sieve();  // crossing off all multiples of small primes
     void printProgress(gint);
-    void sortBigPrimes();
-    void printBigPrimes();
-    void writeBigPrimesToFile();
-    void run();  // run necessary sieve methods; does not gather big primes
-    vector<gint> getBigPrimes(bool = true);  // return the big primes after run()
+    void sortBigPrimes(bool = false);  // by std::sort, or by the radix sort of NormSort.hpp
+    void setBigPrimes();  // gather the big primes into bigPrimes after run()
+    void printBigPrimes(bool = true);  // sorted by norm, or streamed in sieve order
+    void writeBigPrimesToFile(bool = true);
+    void outputBigPrimes(bool, bool, bool);  // sort; print, write to file, in one harvest
+    virtual void run();  // run necessary sieve methods; does not gather big primes
+    vector<gint> getBigPrimes(bool = true, bool = false);  // return the big primes after run(); sort, radix
+    // Pass the big primes to f in chunks of const vector<gint>& after run().
+    template <typename F> void visitBigPrimes(F f) {
+        PrimeVisitor<F> visitor(f);
+        harvestBigPrimes(visitor);
+        visitor.flush();
+    }
 
     // Virtual methods to be implemented in derived classes
     virtual void setSmallPrimes() = 0;
     virtual void setSieveArray() = 0;
     virtual void crossOffMultiples(gint) = 0;
-    virtual void setBigPrimes() = 0;  // results of sieve
+    virtual void harvestBigPrimes(PrimeSink&) = 0;  // results of sieve
     virtual uint64_t getCountBigPrimes() = 0;
 };
 
@@ -70,7 +123,7 @@ public:
 template <typename T>
 class SieveTemplate : public SieveBase {
 protected:
-    vector<vector<T>> sieveArray;  // T will be bool or unsigned int
+    SieveArray<T> sieveArray;  // T will be bool (bit-packed) or unsigned int
 
 public:
     explicit SieveTemplate(uint64_t maxNorm, bool display) : SieveBase(maxNorm, display) {};
@@ -83,4 +136,10 @@ public:
 
 // Useful library-style functions
 uint32_t isqrt(uint64_t);
-uint32_t mod(int64_t, uint32_t);
\ No newline at end of file
+uint32_t floorSqrt(uint64_t);  // as isqrt, from a corrected floating point root
+uint32_t ceilSqrt(uint64_t);
+uint32_t mod(int64_t, uint32_t);
+int64_t floorDiv(int64_t, int64_t);
+// Bounds (lower, upper) of annuli of about equal area covering x1 <= norm <= x2,
+// two for each thread and none more than 2^32 norms wide.
+vector<pair<uint64_t, uint64_t>> equalAreaAnnuli(uint64_t, uint64_t, uint32_t);
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+#include <array>
+#include "BlockSieve.hpp"
+#include "SmallPrimes.hpp"
+using namespace std;
+
+// Sieve many blocks [x, x + dx) x [y, y + dy) as BlockSieve does, without
+// copying the small primes for each one. The small primes up to the square
+// root of the largest norm in any block are taken once from the shared table;
+// a pool of threads then takes the blocks one at a time, and each block
+// crosses off only the small primes up to its own bound. Results are kept per
+// block, in the order the blocks were given.
+class BlockBatch
+{
+private:
+  const vector<array<uint32_t, 4>> blocks; // x, y, dx, dy of each block
+  const bool verbose;
+  const uint32_t threads; // number of worker threads sieving blocks
+  SmallPrimes::View smallPrimes; // sorted by norm
+  template <typename F>
+  void sieveBlocks(F);
+
+public:
+  // 0 threads uses every hardware thread
+  explicit BlockBatch(const vector<array<uint32_t, 4>> &, bool = true, uint32_t = 1);
+  void setSmallPrimes();
+  vector<uint64_t> getCounts();
+  vector<vector<gint>> getBigPrimes(bool = true, bool = false); // sort, radix
+};
@@ -1,23 +1,27 @@
 #pragma once
 #include "BaseSieve.hpp"
+#include "Donut.hpp"
 using namespace std;
 
 class BlockDonutSieve : public SieveTemplate<uint32_t> {
-private:
+protected:  // SegmentedDonutSieve moves the block around the octant
     uint32_t x, y, dx, dy;
-    const int32_t gapDonut[10][10];  // used to jump d during crossOffMultiples()
-    const unsigned char bitDonut[10][10];  // used to compress a gint into a bit position
-    const int32_t realPartDecompress[32];  // used to decompress a bit position into a gint
-    const int32_t imagPartDecompress[32];
+    static constexpr Donut<10> donut = Donut<10>::make();  // 32 residues in a 32-bit word
+    void presieve();  // stamp the pre-sieved pattern over the whole block
+    void crossOffRows(gint, uint32_t, uint32_t);  // multiples in rows [v0, v1) of the block
+    void restorePrime(gint, uint32_t, uint32_t);  // after crossing off its multiples
+    vector<vector<BucketEntry>> fillBandBuckets(uint32_t, uint32_t);
+    void crossOffBandBucket(vector<vector<BucketEntry>>&, uint32_t, uint32_t);
 
 public:
     BlockDonutSieve(uint32_t, uint32_t, uint32_t, uint32_t, bool = true);
     void setFalse(uint32_t, uint32_t);
     void setTrue(uint32_t, uint32_t);
     // overriding virtual methods
+    void sieve() override;  // a band of rows at a time, large primes bucket sieved
     void setSmallPrimes() override;
     void setSieveArray() override;
     void crossOffMultiples(gint) override;
-    void setBigPrimes() override;
+    void harvestBigPrimes(PrimeSink &) override;
     uint64_t getCountBigPrimes() override;
 };
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include "BaseSieve.hpp"
+#include "Divisor.hpp"
+using namespace std;
+
+// Call f(a, b, c, d, dUpper) for every line of multiples (a + bi)(c + di), c
+// fixed and d <= dUpper, of the gint g = a + bi within the box [x, x + dx) x
+// [y, y + dy), skipping lines which miss it. We must have integers c and d with
+// x <= ac - bd < x + dx and y <= ad + bc < y + dy. Solve these for c to get
+// (ax + by) / (a^2 + b^2) <= c <= (a(x + dx - 1) + b(y + dy - 1)) / (a^2 + b^2).
+// Then d is defined by some max and min conditions. Multiples of g are also
+// those of its associate -ig = b - ai, whose lines of fixed c run across the
+// box in the direction of g rather than ig. The associate is taken whenever
+// its lines cross the box fewer times, as for steep primes in tall boxes or
+// shallow ones in wide boxes; b is then negative, and the ends of the bounds
+// above trade places. Either way a > 0, so every line climbs as d grows.
+template <typename F>
+void forEachLine(gint g, int64_t x, int64_t y, int64_t dx, int64_t dy, F f) {
+    int64_t a = g.a;
+    int64_t b = g.b;
+    if (b && (b - a) * (dy - dx) > 0) {
+        a = g.b;
+        b = -int64_t(g.a);
+    }
+    int64_t N = g.norm();
+    // c is least at the lower left corner of the box, or the upper left one
+    // if b < 0, and greatest at the opposite corner.
+    int64_t c = -floorDiv(-(a * x + b * (b >= 0 ? y : y + dy - 1)), N);
+    int64_t cUpper = floorDiv(a * (x + dx - 1) + b * (b >= 0 ? y + dy - 1 : y), N);
+    // The bounds on d are quotients by a and |b|, taken through reciprocals
+    // found once per prime instead of by four divisions for every c.
+    Divisor byA(a);
+    Divisor byB(max(b, -b) + (b == 0));
+    for (; c <= cUpper; c++) {
+        int64_t d = byA.ceilDiv(y - b * c);  // d isn't necessarily positive
+        int64_t dUpper = byA.floorDiv(y + dy - 1 - b * c);
+        if (b > 0) {
+            d = max(d, byB.ceilDiv(a * c - x - dx + 1));
+            dUpper = min(dUpper, byB.floorDiv(a * c - x));
+        } else if (b < 0) {
+            d = max(d, byB.ceilDiv(x - a * c));
+            dUpper = min(dUpper, byB.floorDiv(x + dx - 1 - a * c));
+        }
+        if (d <= dUpper) { f(a, b, c, d, dUpper); }  // narrow boxes miss most lines
+    }
+}
@@ -5,13 +5,18 @@ using namespace std;
 class BlockSieve : public SieveTemplate<bool> {
 private:
     uint32_t x, y, dx, dy;
+    void crossOffRows(gint, uint32_t, uint32_t);  // multiples in rows [v0, v1) of the block
+    void restorePrime(gint, uint32_t, uint32_t);  // after crossing off its multiples
+    vector<vector<BucketEntry>> fillBandBuckets(uint32_t, uint32_t);
+    void crossOffBandBucket(vector<vector<BucketEntry>>&, uint32_t, uint32_t);
 
 public:
     BlockSieve(uint32_t, uint32_t, uint32_t, uint32_t, bool = true);
     // overriding virtual methods
+    void sieve() override;  // a band of rows at a time, large primes bucket sieved
     void setSmallPrimes() override;
     void setSieveArray() override;
     void crossOffMultiples(gint) override;
-    void setBigPrimes() override;
+    void harvestBigPrimes(PrimeSink &) override;
     uint64_t getCountBigPrimes() override;
 };
\ No newline at end of file
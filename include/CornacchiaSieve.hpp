@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+#include "BaseSieve.hpp"
+using namespace std;
+
+// Find Gaussian primes from rational ones. A segmented sieve of Eratosthenes
+// runs over the rational integers n = 1 mod 4 up to x, and each prime p found
+// there is split as p = a^2 + b^2 by the Hermite-Serret algorithm; inert primes
+// q = 3 mod 4 with q^2 <= x and the ramified prime 1 + i are added in between.
+// Primes come out in order of norm, and only the rational primes up to sqrt(x)
+// and a single segment are held in memory. The sieve array has one column, the
+// current segment; bit v stands for n = segmentStart + 4v. Here smallPrimes
+// holds the odd rational primes q up to sqrt(x), as the gints q + 0i.
+class CornacchiaSieve : public SieveTemplate<bool>
+{
+private:
+  const uint32_t segmentSize; // number of n = 1 mod 4 in a segment
+  const uint32_t threads;     // number of worker threads sieving segments
+  uint64_t segmentStart;      // n held by the first bit of the current segment
+
+public:
+  // 0 threads uses every hardware thread; 256 KB segments by default
+  explicit CornacchiaSieve(uint64_t, bool = true, uint32_t = 1, uint32_t = 256);
+  static gint splitPrime(uint64_t); // a + bi with a > b > 0 and a^2 + b^2 = p
+  uint64_t getSegmentCount();
+  void setSegment(uint64_t);
+  void sieveSegment();
+  uint64_t gatherSegment(PrimeSink *);
+  uint64_t sweepSegments(atomic<uint64_t> &);
+  // overriding virtual methods
+  void run() override;
+  void setSmallPrimes() override;
+  void setSieveArray() override;
+  void crossOffMultiples(gint) override;
+  void harvestBigPrimes(PrimeSink &) override;
+  uint64_t getCountBigPrimes() override;
+};
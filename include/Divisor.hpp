@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+using namespace std;
+
+// Division by a fixed m > 0 through a floating point reciprocal computed once.
+// For |n| < 2^52 the product n (1 / m) truncates to within one of floor(n / m),
+// and the remainder then fixes the quotient, so no division is left in loops
+// which divide many numerators by the same m.
+struct Divisor {
+    int64_t m;
+    double inverse;
+
+    explicit Divisor(int64_t m) : m(m), inverse(1.0 / double(m)) {}
+
+    int64_t floorDiv(int64_t n) const {
+        int64_t q = int64_t(double(n) * inverse);
+        int64_t r = n - q * m;
+        return q - (r < 0) + (r >= m);
+    }
+    int64_t ceilDiv(int64_t n) const { return -floorDiv(-n); }
+};
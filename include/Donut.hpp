@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+using namespace std;
+
+
+// Wheel (donut) tables for sieving with a modulus M, generated at compile time.
+// A residue class c + di mod M is kept in the donut when c + di is coprime to
+// every Gaussian prime dividing M, that is, when c^2 + d^2 is coprime to M.
+// Residues are numbered c-major, so a block of M x M gints is compressed into
+// nResidues bits; with M = 10 these are the 32 bits of one donut word.
+constexpr uint32_t constexprGcd(uint32_t m, uint32_t n) {
+    while (n) {
+        uint32_t r = m % n;
+        m = n;
+        n = r;
+    }
+    return m;
+}
+
+constexpr uint32_t countDonutResidues(uint32_t M) {
+    uint32_t count = 0;
+    for (uint32_t c = 0; c < M; c++) {
+        for (uint32_t d = 0; d < M; d++) {
+            if (constexprGcd((c * c + d * d) % M, M) == 1) { count++; }
+        }
+    }
+    return count;
+}
+
+template <uint32_t M>
+struct Donut {
+    static constexpr uint32_t modulus = M;
+    static constexpr uint32_t nResidues = countDonutResidues(M);
+    static constexpr uint16_t notInDonut = UINT16_MAX;
+
+    uint8_t dStart[M];  // used to start d during crossOffMultiples()
+    uint8_t gap[M][M];  // used to jump d during crossOffMultiples(); 0 if not in donut
+    uint16_t bit[M][M];  // used to compress a gint into a bit position
+    uint8_t realPart[nResidues];  // used to decompress a bit position into a gint
+    uint8_t imagPart[nResidues];
+
+    static constexpr Donut make() {
+        Donut t{};
+        bool coprime[M] = {};  // is n coprime to M
+        for (uint32_t n = 0; n < M; n++) { coprime[n] = constexprGcd(n, M) == 1; }
+
+        uint16_t k = 0;
+        for (uint32_t c = 0; c < M; c++) {
+            // Walk down two periods of d so the gap out of the last residue wraps around.
+            uint32_t next = 2 * M;
+            for (uint32_t e = 2 * M; e-- > 0;) {
+                uint32_t d = e % M;
+                if (coprime[(c * c + d * d) % M]) {
+                    if (e < M) { t.gap[c][d] = uint8_t(next - e); }
+                    next = e;
+                }
+            }
+            t.dStart[c] = uint8_t(next);
+            for (uint32_t d = 0; d < M; d++) {
+                if (coprime[(c * c + d * d) % M]) {
+                    t.bit[c][d] = k;
+                    t.realPart[k] = uint8_t(c);
+                    t.imagPart[k] = uint8_t(d);
+                    k++;
+                } else {
+                    t.bit[c][d] = notInDonut;
+                }
+            }
+        }
+        return t;
+    }
+};
+
+template <uint32_t M> constexpr uint32_t Donut<M>::modulus;
+template <uint32_t M> constexpr uint32_t Donut<M>::nResidues;
+template <uint32_t M> constexpr uint16_t Donut<M>::notInDonut;
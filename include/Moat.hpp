@@ -37,7 +37,7 @@ private:
   static uint32_t realPart;
   static int32_t blockSize, dx, dy;
   static uint64_t sievingPrimesNormBound;
-  static vector<gint> sievingPrimes, nearestNeighbors;
+  static vector<gint> nearestNeighbors;
 
   // Instance variables.
   uint32_t x, y;
@@ -67,8 +67,7 @@ private:
   static double jumpSize;
   static uint32_t previousdy;
   static uint64_t blockSize;
-  static uint64_t sievingPrimesNormBound;
-  static vector<gint> sievingPrimes, nearestNeighbors;
+  static vector<gint> nearestNeighbors;
 
   // The index of the outer vector determines which component number the inner
   // vector corresponds with.
@@ -88,7 +87,6 @@ private:
 
 public:
   static void setStatics(double, bool = true);
-  static void setSievingPrimes();
   static uint64_t getCountMainComponent();
 
   SegmentedMoat(uint32_t, uint32_t, uint32_t);
@@ -0,0 +1,48 @@
+#pragma once
+#include <iterator>
+#include "BaseSieve.hpp"
+using namespace std;
+
+// The Gaussian primes of the first quadrant with norm at least start, in the
+// order given by operator< on gint, with no upper bound fixed in advance. Norms
+// are covered by successive annuli [N_k, N_k + width), each sieved on its own
+// by AnnulusSieve and then sorted, so memory stays proportional to the width
+// plus the sieving primes, which are taken from the shared SmallPrimes table.
+class NormOrderedPrimes
+{
+private:
+  const uint64_t width;
+  uint64_t lower; // norm at which the next annulus starts
+  vector<gint> annulus; // primes of the current annulus, sorted
+  size_t position; // index in annulus of the next prime
+  void sieveNextAnnulus();
+
+public:
+  explicit NormOrderedPrimes(uint64_t = 0, uint64_t = 1 << 22); // start, width
+  gint next(); // the next prime in norm order
+
+  // An input iterator over the endless range, for use in range-based loops.
+  // The loop never ends by itself; break out of it.
+  class iterator
+  {
+  private:
+    NormOrderedPrimes *primes;
+    gint current;
+
+  public:
+    using iterator_category = input_iterator_tag;
+    using value_type = gint;
+    using difference_type = ptrdiff_t;
+    using pointer = const gint *;
+    using reference = const gint &;
+    explicit iterator(NormOrderedPrimes *primes)
+        : primes(primes), current(primes ? primes->next() : gint(0, 0)) {}
+    reference operator*() const { return current; }
+    pointer operator->() const { return &current; }
+    iterator &operator++() { current = primes->next(); return *this; }
+    bool operator==(const iterator &other) const { return primes == other.primes; }
+    bool operator!=(const iterator &other) const { return primes != other.primes; }
+  };
+  iterator begin() { return iterator(this); }
+  iterator end() { return iterator(nullptr); }
+};
@@ -0,0 +1,15 @@
+#pragma once
+#include <vector>
+#include "BaseSieve.hpp"
+using namespace std;
+
+
+// Sorting gints by norm in exactly the order given by operator< on gint, with
+// ties broken by larger real part first. Instead of recomputing two norms in
+// every comparison, each gint is given a 64-bit key holding its norm in the
+// high bits and its (reversed) real part in the low bits; the keys are then
+// split in place into buckets by their top bits, and each bucket is ordered by
+// an LSD radix sort, 11 bits per pass, on several threads. Scratch memory is
+// only as large as the largest bucket. If the keys do not fit into 64 bits,
+// std::sort is used instead.
+void radixSortByNorm(vector<gint>&, uint32_t = 0);  // 0 threads uses every hardware thread
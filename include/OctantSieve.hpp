@@ -14,6 +14,6 @@ public:
   void setSmallPrimes() override;
   void setSieveArray() override;
   void crossOffMultiples(gint) override;
-  void setBigPrimes() override;
+  void harvestBigPrimes(PrimeSink &) override;
   uint64_t getCountBigPrimes() override;
 };
\ No newline at end of file
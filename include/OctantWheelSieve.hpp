@@ -0,0 +1,31 @@
+#pragma once
+#include "BaseSieve.hpp"
+#include "Donut.hpp"
+using namespace std;
+
+// Octant sieve over a donut of modulus M generated at compile time. Each block
+// of M x M gints is compressed into Donut<M>::nResidues bits held in 64-bit
+// words, stacked up each column of blocks. OctantDonutSieve is the M = 10 case
+// with one 32-bit word per block.
+template <uint32_t M>
+class OctantWheelSieve : public SieveTemplate<uint64_t>
+{
+private:
+  const uint64_t x;
+  static constexpr uint32_t nWords = Donut<M>::nResidues / 64; // words per block
+  static constexpr Donut<M> donut = Donut<M>::make();
+  static_assert(Donut<M>::nResidues % 64 == 0, "a block must fill whole 64-bit words");
+
+public:
+  explicit OctantWheelSieve(uint64_t, bool = true);
+  vector<gint> getWheelPrimes(); // primes dividing M, which are not in the donut
+  void setFalse(uint32_t, uint32_t);
+  void setTrue(uint32_t, uint32_t);
+  uint32_t getInteriorBlocks(uint32_t);
+  // overriding virtual methods
+  void setSmallPrimes() override;
+  void setSieveArray() override;
+  void crossOffMultiples(gint) override;
+  void harvestBigPrimes(PrimeSink &) override;
+  uint64_t getCountBigPrimes() override;
+};
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+#include "BaseSieve.hpp"
+using namespace std;
+
+
+// Pre-sieving by the smallest Gaussian primes 1 + i, 2 + i, 1 + 2i, 3, 3 + 2i
+// and 2 + 3i. A gint a + bi is a multiple of one of these exactly when its norm
+// shares a factor with 2 * 3 * 5 * 13, so the gints surviving them form a
+// pattern which is periodic in both a and b. Sieves stamp this pattern into the
+// sieve array in setSieveArray() and skip these primes in crossOffMultiples().
+const uint32_t presieveModulus = 390;  // 2 * 3 * 5 * 13
+const uint32_t presieveWords = 195;  // 64 * 195 bits is a whole number of periods
+const uint32_t presieveDonutModulus = 39;  // 2 and 5 are already left out of the donut
+
+bool isPresieved(gint);  // is g one of the pre-sieved primes (up to units)
+const uint64_t* presieveColumn(uint32_t);  // bits b = 0, 1, ... of the column a
+const uint32_t* presieveDonutColumn(uint32_t);  // donut words B = 0, 1, ... of the column A
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+using namespace std;
+
+// Counting Gaussian primes, including associates, of norm up to x without
+// sieving the Gaussian integers. A rational prime p = 1 mod 4 splits into 8
+// associated Gaussian primes of norm p, a prime p = 3 mod 4 stays inert and
+// gives 4 of norm p^2, and 2 ramifies into the 4 associates of 1 + i. So only
+// rational primes in residue classes mod 4 up to x and sqrt(x) are counted,
+// which takes O(x^(3/4)) time and O(sqrt(x)) memory.
+uint64_t countGPrimesToNorm(uint64_t);
+
+// Counting rational primes p <= x with p = 1 mod 4 and with p = 3 mod 4.
+pair<uint64_t, uint64_t> countPrimesMod4(uint64_t);
@@ -0,0 +1,39 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "BaseSieve.hpp"
+using namespace std;
+
+// The primes harvested by a sieve, handed out in chunks while the sieve is
+// still running. The harvest, given as a function pushing primes onto a sink,
+// runs on a producer thread of its own; full chunks wait in a queue holding at
+// most depth of them, and the producer blocks while the queue is full. Memory
+// is then that of the sieve plus a few chunks, and sieving overlaps with
+// whatever is done with the chunks already taken. Chunks come in the order the
+// sieve harvests them, not sorted by norm.
+class PrimeStream
+{
+private:
+  const size_t chunkSize;
+  const size_t depth;
+  mutex lock;
+  condition_variable changed;
+  deque<vector<gint>> queue;
+  bool done;      // the producer has pushed its last chunk
+  bool cancelled; // the consumer has gone; the producer should stop
+  exception_ptr error; // thrown by the harvest, rethrown by next()
+  thread producer;
+  class QueueSink;
+  void enqueue(vector<gint> &&);
+
+public:
+  PrimeStream(function<void(PrimeSink &)>, size_t, size_t = 2); // harvest, chunk size, depth
+  ~PrimeStream(); // stops the producer at its next chunk
+  PrimeStream(const PrimeStream &) = delete;
+  PrimeStream &operator=(const PrimeStream &) = delete;
+  vector<gint> next(); // the next chunk; empty once the harvest is over
+};
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <cmath>
+#include "BaseSieve.hpp"
+using namespace std;
+
+typedef __int128 int128_t;
+
+
+// Floor of n / d for d > 0, rounding towards minus infinity.
+inline int128_t floorDiv(int128_t n, int128_t d) {
+    int128_t q = n / d;
+    return (n % d < 0) ? q - 1 : q;
+}
+
+
+// A ray from the origin, held as an integer direction vector (p, q) with
+// p > 0. Which side of the ray a gint lies on is decided exactly by a cross
+// product, so the bounds of a sector need no tolerance. A ray at angle theta
+// in [0, pi/2] gets (p, q) = 2^62 (cos theta, sin theta), rounded; as pi/2 is
+// never given exactly in floating point, p stays positive.
+struct Ray {
+    int128_t p, q;
+
+    Ray(int128_t p, int128_t q) : p(p), q(q) {}
+    explicit Ray(long double theta)
+        : p(llroundl(ldexpl(cosl(theta), 62))), q(llroundl(ldexpl(sinl(theta), 62))) {
+        if (p <= 0) { p = 1; }  // a ray past the imaginary axis
+    }
+
+    // The ray turned back by arg(g), that is, multiplied by the conjugate of g.
+    // The multiple g (c + di) lies above this ray exactly when c + di lies above
+    // the turned ray, and p stays positive for g in the first quadrant as long
+    // as the angle between the two is less than pi/2.
+    Ray turnedBack(gint g) const { return Ray(p * g.a + q * g.b, q * g.a - p * g.b); }
+
+    // Is a + bi on the ray or above it (counterclockwise from it).
+    bool isOnOrAbove(int64_t a, int64_t b) const { return p * b - q * a >= 0; }
+
+    // Smallest b with a + bi on the ray or above it.
+    int128_t lowestAbove(int64_t a) const { return -floorDiv(-q * a, p); }
+
+    // At most n p^2 / (p^2 + q^2), n cos^2 of the ray for q >= 0. The
+    // products would not fit in 128 bits, so p and q are cut to 31 bits,
+    // rounding p down and q up.
+    uint64_t cosSquaredBelow(uint64_t n) const {
+        int shift = 0;
+        while ((p >> shift) >= (int128_t(1) << 31) || (q >> shift) >= (int128_t(1) << 31)) { shift++; }
+        int128_t c = p >> shift;
+        int128_t s = (q >> shift) + 1;
+        return uint64_t(n * c * c / (c * c + s * s));
+    }
+};
+
+
+// The heights lowestAbove(c) of a ray on the lines c = c0, c0 + 1, ..., stepped
+// with additions only; quotient and remainder are those of q c by p.
+struct RayWalk {
+    int128_t p, stepQuotient, stepRemainder, quotient, remainder;
+
+    RayWalk(const Ray& r, int64_t c0) : p(r.p) {
+        stepQuotient = floorDiv(r.q, p);
+        stepRemainder = r.q - stepQuotient * p;
+        quotient = floorDiv(r.q * c0, p);
+        remainder = r.q * c0 - quotient * p;
+    }
+    void next() {
+        quotient += stepQuotient;
+        remainder += stepRemainder;
+        if (remainder >= p) {
+            remainder -= p;
+            quotient++;
+        }
+    }
+    int128_t lowestAbove() const { return quotient + (remainder != 0); }
+};
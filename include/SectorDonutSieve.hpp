@@ -0,0 +1,51 @@
+#pragma once
+#include "BaseSieve.hpp"
+#include "Donut.hpp"
+#include "Ray.hpp"
+#include <cmath>
+#include <memory>
+using namespace std;
+
+// SectorSieve on the donut of gints coprime to 1 + i and 2 + i, compressed as
+// in OctantDonutSieve: word B of column A holds the 10 x 10 block with lower
+// left corner 10A0 + 10A + 10Bi. Column A only holds the words B =
+// heightShifts[A], ..., which meet the sector; gints a + bi of the sector are
+// those with bLows[a - 10A0] <= b <= bHighs[a - 10A0]. Given an inner norm x1,
+// only the part of the sector with norm at least x1 is sieved.
+// With several threads, run() cuts the sector into annular pieces of equal
+// area, which are sieved by a pool of workers with one shared list of small
+// primes; the pieces are gathered and counted in order of norm.
+class SectorDonutSieve : public SieveTemplate<uint32_t>
+{
+private:
+  uint64_t x1, x;
+  long double alpha, beta;
+  Ray alphaRay, betaRay; // integer direction vectors of the rays bounding the sector
+  const uint32_t threads; // number of worker threads sieving pieces
+  uint32_t A0; // first column of words, holding the real parts 10A0, ...
+  vector<int32_t> bLows, bHighs; // range of imaginary parts in each column of gints
+  vector<uint32_t> heightShifts; // lowest word held in each column of words
+  vector<unique_ptr<SectorDonutSieve>> pieces; // annular pieces sieved in parallel
+  static constexpr Donut<10> donut = Donut<10>::make(); // 32 residues in a 32-bit word
+  bool inSector(uint32_t, uint32_t);
+  uint32_t getInteriorBegin(uint32_t);
+  uint32_t getInteriorEnd(uint32_t);
+  void crossOffLine(gint, uint32_t, int128_t, int128_t);
+  // x, alpha, beta, verbose, threads, then the inner norm x1
+  SectorDonutSieve(uint64_t, long double, long double, bool, uint32_t, uint64_t);
+
+public:
+  // 0 threads uses every hardware thread
+  SectorDonutSieve(uint64_t, long double, long double, bool = true, uint32_t = 1);
+  // The part x1 <= norm <= x of the sector, given as x1, x, alpha, beta.
+  static unique_ptr<SectorDonutSieve> annulus(uint64_t, uint64_t, long double, long double, bool = true, uint32_t = 1);
+  void setFalse(uint32_t, uint32_t);
+  void setTrue(uint32_t, uint32_t);
+  // overriding virtual methods
+  void run() override;
+  void setSmallPrimes() override;
+  void setSieveArray() override;
+  void crossOffMultiples(gint) override;
+  void harvestBigPrimes(PrimeSink &) override;
+  uint64_t getCountBigPrimes() override;
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <array>
+#include "Ray.hpp"
+#include "SmallPrimes.hpp"
+using namespace std;
+
+// Races between the primes of pairs of sectors: race k counts the primes with
+// alpha <= arg < beta against those with gamma <= arg < delta, for the angles
+// (alpha, beta, gamma, delta) of its entry. Bin i of its norm data holds the
+// first count minus the second for norms below (i + 1) x / nBins, the last bin
+// for norms up to x, as SectorRace always binned them. The sectors
+// are merged into groups of overlapping angles, each sieved once as a single
+// enclosing sector by SectorDonutSieve, so no prime is sieved twice whatever
+// the number of races. Each group is cut into annuli of equal area, which a
+// pool of threads takes from a shared counter; the primes of an annulus are
+// tallied as they are harvested, and are kept only when asked for.
+class SectorRaces
+{
+private:
+  const uint64_t x, nBins;
+  const vector<array<long double, 4>> races; // alpha, beta, gamma, delta of each race
+  const bool keepPrimes;
+  const bool verbose;
+  const uint32_t threads; // number of worker threads sieving annuli
+  vector<long double> angles; // every distinct angle of a sector, increasing
+  vector<Ray> boundaries; // the integer rays at these angles
+  // Sectors 2k and 2k + 1 are the two sides of race k; sector j runs from
+  // ray sectorBegin[j] up to ray sectorEnd[j].
+  vector<uint32_t> sectorBegin, sectorEnd;
+  vector<vector<int64_t>> normData; // per race, cumulative once run
+  vector<vector<gint>> sectorPrimes; // per sector, when keepPrimes
+  uint32_t cellOf(gint, uint32_t, uint32_t) const;
+
+public:
+  // 0 threads uses every hardware thread
+  SectorRaces(uint64_t, uint64_t, const vector<array<long double, 4>> &, bool = false, bool = true, uint32_t = 1);
+  void run();
+  const vector<int64_t> &getNormData(uint32_t) const; // of a race
+  const vector<gint> &getSectorPrimes(uint32_t) const; // of a sector
+  vector<gint> takeSectorPrimes(uint32_t); // moved out, leaving it empty
+};
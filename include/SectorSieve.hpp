@@ -1,5 +1,6 @@
 #pragma once
 #include "BaseSieve.hpp"
+#include "Ray.hpp"
 #include <cmath>
 using namespace std;
 
@@ -8,9 +9,9 @@ class SectorSieve : public SieveTemplate<bool>
 private:
   uint64_t x;
   long double alpha, beta;
-  // Only need tolerance when alpha or beta is close to rational multiple of pi.
-  const long double tolerance = pow(10, -10);
+  Ray alphaRay, betaRay; // integer direction vectors of the rays bounding the sector
   vector<int32_t> heightShifts;
+  bool inSector(gint);
 
 public:
   SectorSieve(uint64_t, long double, long double, bool = true);
@@ -19,6 +20,6 @@ public:
   void setSmallPrimes() override;
   void setSieveArray() override;
   void crossOffMultiples(gint) override;
-  void setBigPrimes() override;
+  void harvestBigPrimes(PrimeSink &) override;
   uint64_t getCountBigPrimes() override;
-};
\ No newline at end of file
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <atomic>
+#include "BlockDonutSieve.hpp"
+using namespace std;
+
+// Sieve the first octant in square tiles of donut words, one tile at a time.
+// Each tile is the block of the parent BlockDonutSieve, which is moved around
+// the octant; only the small primes and a single tile are held in memory.
+// With more than one thread, each worker sieves whole strips of tiles on its
+// own copy of the sieve, so no tile is ever shared between threads.
+// Sieving primes of norm larger than the area of a tile are bucket sieved: for
+// every cofactor c, the line of multiples (a + bi)(c + di) is filed under the
+// next tile of the strip it meets, and only touched again there.
+
+class SegmentedDonutSieve : public BlockDonutSieve
+{
+private:
+  const uint64_t normBound;
+  const uint32_t tileSize; // side length of a tile in donut words
+  const uint32_t threads;  // number of worker threads sweeping strips of tiles
+  uint32_t firstLarge;     // index in smallPrimes of the first bucket sieved prime
+  vector<vector<BucketEntry>> buckets; // one bucket per tile of the current strip
+
+public:
+  // 0 threads uses every hardware thread; 256 KB tiles by default
+  explicit SegmentedDonutSieve(uint64_t, bool = true, uint32_t = 1, uint32_t = 256);
+  uint32_t getTopWord(uint32_t);
+  uint32_t getInteriorWords(uint32_t);
+  void setTile(uint32_t, uint32_t);
+  void sieveTile();
+  void fillBuckets(uint32_t, uint32_t);
+  void crossOffBucket(uint32_t);
+  uint64_t gatherTile(PrimeSink *);
+  uint64_t sweepStrips(atomic<uint32_t> &, PrimeSink *);
+  uint64_t sweep(PrimeSink *); // nullptr only counts
+  // overriding virtual methods
+  void run() override;
+  void setSmallPrimes() override;
+  void harvestBigPrimes(PrimeSink &) override;
+  uint64_t getCountBigPrimes() override;
+};
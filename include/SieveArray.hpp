@@ -0,0 +1,194 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+using namespace std;
+
+
+// Allocator handing out memory which starts on a cache line boundary.
+template <typename T>
+struct CacheAlignedAllocator {
+    typedef T value_type;
+    static const size_t alignment = 64;  // bytes in a cache line
+
+    CacheAlignedAllocator() = default;
+    template <typename U> CacheAlignedAllocator(const CacheAlignedAllocator<U>&) {}
+    T* allocate(size_t n) {
+        void* p = nullptr;
+        if (posix_memalign(&p, alignment, n ? n * sizeof(T) : alignment)) {
+            throw bad_alloc();
+        }
+        return static_cast<T*>(p);
+    }
+    void deallocate(T* p, size_t) { free(p); }
+    template <typename U> bool operator == (const CacheAlignedAllocator<U>&) const { return true; }
+    template <typename U> bool operator != (const CacheAlignedAllocator<U>&) const { return false; }
+};
+
+
+// Ragged two-dimensional sieve array held in a single contiguous, cache
+// aligned buffer. Column u occupies the entries offsets[u] up to but not
+// including offsets[u + 1], so the octant and sector shapes need no padding.
+// The generic version stores words of type T; sieveArray[u][v] is a reference
+// to the word at index v of column u.
+template <typename T>
+class SieveArray {
+private:
+    vector<T, CacheAlignedAllocator<T>> data;
+    vector<uint64_t> offsets{0};  // size() + 1 entries
+
+public:
+    // Build columns of the given heights with every entry equal to value.
+    void assign(const vector<uint32_t>& heights, T value) {
+        offsets.assign(1, 0);
+        offsets.reserve(heights.size() + 1);
+        for (uint32_t h : heights) { offsets.push_back(offsets.back() + h); }
+        data.assign(offsets.back(), value);
+    }
+    void assign(uint32_t nColumns, uint32_t height, T value) {
+        assign(vector<uint32_t>(nColumns, height), value);
+    }
+    void fill(T value) { data.assign(data.size(), value); }
+    // Overwrite column u with a periodic pattern; entry v of the column becomes
+    // pattern[(v + phase) % period]. Whole periods are copied with memcpy.
+    void stamp(uint32_t u, const T* pattern, uint32_t period, uint32_t phase) {
+        T* column = (*this)[u];
+        uint32_t height = columnSize(u);
+        phase %= period;
+        uint32_t v = min(height, period - phase);
+        memcpy(column, pattern + phase, v * sizeof(T));
+        for (; v < height; v += period) { memcpy(column + v, pattern, min(period, height - v) * sizeof(T)); }
+    }
+
+    uint32_t size() const { return offsets.size() - 1; }  // number of columns
+    uint32_t columnSize(uint32_t u) const { return offsets[u + 1] - offsets[u]; }
+    uint64_t nEntries() const { return data.size(); }
+    uint64_t memoryUse() const {  // in bytes
+        return data.capacity() * sizeof(T) + offsets.capacity() * sizeof(uint64_t);
+    }
+
+    T* operator [] (uint32_t u) { return data.data() + offsets[u]; }
+    const T* operator [] (uint32_t u) const { return data.data() + offsets[u]; }
+    T at(uint32_t u, uint32_t v) const {  // bounds checked
+        if ((u >= size()) || (v >= columnSize(u))) { throw out_of_range("index not in sieve array"); }
+        return (*this)[u][v];
+    }
+
+    // Copy into the nested vector layout returned by getSieveArray().
+    vector<vector<T>> toVectors() const {
+        vector<vector<T>> v;
+        v.reserve(size());
+        for (uint32_t u = 0; u < size(); u++) { v.emplace_back((*this)[u], (*this)[u] + columnSize(u)); }
+        return v;
+    }
+};
+
+
+// Boolean sieve arrays are bit-packed into 64-bit words, with columns laid
+// end to end in one stream of bits. Use test(), set() and reset() as with a
+// bitset; there are no proxy objects as in vector<bool>.
+template <>
+class SieveArray<bool> {
+private:
+    vector<uint64_t, CacheAlignedAllocator<uint64_t>> data;
+    vector<uint64_t> offsets{0};  // bit offsets; size() + 1 entries
+
+public:
+    void assign(const vector<uint32_t>& heights, bool value) {
+        offsets.assign(1, 0);
+        offsets.reserve(heights.size() + 1);
+        for (uint32_t h : heights) { offsets.push_back(offsets.back() + h); }
+        data.assign((offsets.back() + 63) / 64, value ? UINT64_MAX : 0);
+    }
+    void assign(uint32_t nColumns, uint32_t height, bool value) {
+        assign(vector<uint32_t>(nColumns, height), value);
+    }
+    void fill(bool value) { data.assign(data.size(), value ? UINT64_MAX : 0); }
+    // Overwrite column u with a periodic bit pattern held in nWords words; bit v
+    // of the column becomes bit (v + phase) % (64 * nWords) of the pattern. The
+    // pattern is shifted into place a whole word at a time.
+    void stamp(uint32_t u, const uint64_t* pattern, uint32_t nWords, uint64_t phase) {
+        uint64_t begin = offsets[u];
+        uint64_t end = offsets[u + 1];
+        if (begin == end) { return; }
+        uint64_t period = 64 * uint64_t(nWords);
+        // position in the pattern of the first bit of the word holding bit begin
+        uint64_t s = (phase % period + period - (begin & 63)) % period;
+        for (uint64_t w = begin >> 6; w <= (end - 1) >> 6; w++) {
+            uint64_t k = s >> 6;
+            uint64_t shift = s & 63;
+            uint64_t word = shift ? (pattern[k] >> shift) | (pattern[(k + 1) % nWords] << (64 - shift)) : pattern[k];
+            uint64_t mask = UINT64_MAX;  // bits of word w within column u
+            if (w == begin >> 6) { mask &= UINT64_MAX << (begin & 63); }
+            if (w == (end - 1) >> 6) { mask &= UINT64_MAX >> (63 - ((end - 1) & 63)); }
+            data[w] = (data[w] & ~mask) | (word & mask);
+            s = (s + 64) % period;
+        }
+    }
+
+    uint32_t size() const { return offsets.size() - 1; }
+    uint32_t columnSize(uint32_t u) const { return offsets[u + 1] - offsets[u]; }
+    uint64_t nEntries() const { return offsets.back(); }
+    uint64_t memoryUse() const {
+        return data.capacity() * sizeof(uint64_t) + offsets.capacity() * sizeof(uint64_t);
+    }
+
+    bool test(uint32_t u, uint32_t v) const {
+        uint64_t i = offsets[u] + v;
+        return (data[i >> 6] >> (i & 63)) & 1u;
+    }
+    void set(uint32_t u, uint32_t v) {
+        uint64_t i = offsets[u] + v;
+        data[i >> 6] |= uint64_t(1) << (i & 63);
+    }
+    void reset(uint32_t u, uint32_t v) {
+        uint64_t i = offsets[u] + v;
+        data[i >> 6] &= ~(uint64_t(1) << (i & 63));
+    }
+    bool at(uint32_t u, uint32_t v) const {
+        if ((u >= size()) || (v >= columnSize(u))) { throw out_of_range("index not in sieve array"); }
+        return test(u, v);
+    }
+
+    // Number of set bits v with begin <= v < end in column u, a word at a time.
+    uint64_t count(uint32_t u, uint32_t begin, uint32_t end) const {
+        if (begin >= end) { return 0; }
+        uint64_t i = offsets[u] + begin;
+        uint64_t j = offsets[u] + end - 1;  // last bit in the range
+        uint64_t first = UINT64_MAX << (i & 63);
+        uint64_t last = UINT64_MAX >> (63 - (j & 63));
+        if (i >> 6 == j >> 6) { return __builtin_popcountll(data[i >> 6] & first & last); }
+        uint64_t n = __builtin_popcountll(data[i >> 6] & first) + __builtin_popcountll(data[j >> 6] & last);
+        for (uint64_t w = (i >> 6) + 1; w < j >> 6; w++) { n += __builtin_popcountll(data[w]); }
+        return n;
+    }
+    // Call f(v) for each set bit v with begin <= v < end in column u, in
+    // increasing order, jumping from one set bit to the next with ctz.
+    template <typename F>
+    void forEach(uint32_t u, uint32_t begin, uint32_t end, F f) const {
+        if (begin >= end) { return; }
+        uint64_t i = offsets[u] + begin;
+        uint64_t j = offsets[u] + end - 1;
+        for (uint64_t w = i >> 6; w <= j >> 6; w++) {
+            uint64_t word = data[w];
+            if (w == i >> 6) { word &= UINT64_MAX << (i & 63); }
+            if (w == j >> 6) { word &= UINT64_MAX >> (63 - (j & 63)); }
+            for (; word; word &= word - 1) { f(uint32_t((w << 6) + __builtin_ctzll(word) - offsets[u])); }
+        }
+    }
+
+    vector<vector<bool>> toVectors() const {
+        vector<vector<bool>> v;
+        v.reserve(size());
+        for (uint32_t u = 0; u < size(); u++) {
+            vector<bool> column(columnSize(u));
+            for (uint32_t w = 0; w < column.size(); w++) { column[w] = test(u, w); }
+            v.push_back(column);
+        }
+        return v;
+    }
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "BaseSieve.hpp"
+using namespace std;
+
+// A process-wide table of the Gaussian primes of the first octant and their
+// flips, sorted by norm as OctantSieve gives them, from which every sieve takes
+// its small primes. The table grows when a larger norm is asked for: only the
+// annulus beyond the current bound is sieved, by AnnulusSieve with primes
+// already in the table. A view holds on to the table it was cut from, so it
+// stays valid and unchanged while the table grows.
+//
+// Given a cache file, by setCacheFile() or the environment variable
+// GINT_PRIMES_CACHE, the table is memory-mapped from the file before anything
+// is sieved, and the file is rewritten whenever the table grows past it.
+class SmallPrimes
+{
+public:
+  class View
+  {
+  private:
+    shared_ptr<const gint> table;
+    size_t n;
+
+  public:
+    View(shared_ptr<const gint> table, size_t n) : table(table), n(n) {}
+    const gint *begin() const { return table.get(); }
+    const gint *end() const { return table.get() + n; }
+    size_t size() const { return n; }
+    bool empty() const { return n == 0; }
+    gint operator[](size_t k) const { return table.get()[k]; }
+    vector<gint> toVector() const { return vector<gint>(begin(), end()); }
+  };
+
+  static View upTo(uint64_t); // every prime of norm at most x
+  static uint64_t getBound(); // norm up to which the table is complete
+  static void setCacheFile(const string &); // for every sieve; empty to stop using a file
+  // Every prime of norm at most x, from the cache file at path if it reaches x,
+  // and otherwise from the table, then written to path. The cache file of
+  // setCacheFile() is left as it is.
+  static View fromFile(const string &, uint64_t);
+
+private:
+  static mutex tableMutex;
+  static condition_variable tableGrown; // notified when an extension ends
+  static bool extending; // whether a thread is sieving a larger table
+  static shared_ptr<const gint> table;
+  static size_t tableSize;
+  static uint64_t bound;
+  static string cacheFile;
+  static shared_ptr<vector<gint>> extend(const View &, uint64_t, uint64_t);
+  static bool loadCache();
+};
@@ -0,0 +1,35 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+using namespace std;
+
+
+// The number of worker threads for a request of threads, where 0 asks for
+// every hardware thread.
+inline uint32_t threadCount(uint32_t threads) {
+    return threads ? threads : max(thread::hardware_concurrency(), 1u);
+}
+
+// Run f(t) for t = 0, ..., threads - 1, each on its own thread; f(0) runs on
+// the calling thread.
+template <typename F>
+void onThreads(uint32_t threads, F f) {
+    vector<thread> pool;
+    for (uint32_t t = 1; t < threads; t++) { pool.emplace_back(f, t); }
+    f(0);
+    for (thread& worker : pool) { worker.join(); }
+}
+
+// Run f(k, t) for k = 0, ..., n - 1, on a pool of threads t = 0, ...,
+// threads - 1 which take the next k from a shared counter as they finish the
+// last, so uneven pieces of work keep every thread busy to the end.
+template <typename F>
+void forEachOnThreads(uint32_t threads, uint64_t n, F f) {
+    atomic<uint64_t> next(0);
+    onThreads(threads, [&](uint32_t t) {
+        for (uint64_t k = next++; k < n; k = next++) { f(k, t); }
+    });
+}
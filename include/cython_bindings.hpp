@@ -1,54 +1,91 @@
 #pragma once
 #include <vector>
+#include <string>
 #include "BaseSieve.hpp"
 #include "BlockSieve.hpp"
+#include "NormOrderedPrimes.hpp"
+#include "PrimeStream.hpp"
 using namespace std;
 
-// Convert a vector of gints to a flattened array, then return pointer and size.
-pair<int32_t *, uint64_t> gintVectorToArray(vector<gint>);
+// Primes handed over to numpy without a copy: data holds the real and
+// imaginary parts of each of the size primes in turn, and stays valid until
+// freeGintArray is called on owner, the vector<gint> holding it.
+struct GintArray
+{
+  int32_t *data;
+  uint64_t size;
+  void *owner;
+};
+GintArray gintVectorToArray(vector<gint>);
+void freeGintArray(void *);
 
 // Return containers which get slowly copied into python structures.
 vector<pair<int32_t, int32_t>> gPrimesToNorm(uint64_t);
 vector<pair<int32_t, int32_t>> gPrimesInSector(uint64_t, double, double);
 vector<pair<int32_t, int32_t>> gPrimesInBlock(uint32_t, uint32_t, uint32_t, uint32_t);
 
-// Return counts only.
-uint64_t gPrimesToNormCount(uint64_t);
-uint64_t gPrimesInSectorCount(uint64_t, double, double);
+// Return counts only. The optional argument is a number of threads; anything
+// other than 1 calls the multithreaded SegmentedDonutSieve, or cuts a sector
+// into annular pieces sieved in parallel.
+uint64_t gPrimesToNormCount(uint64_t, uint32_t = 1);
+uint64_t gPrimesInSectorCount(uint64_t, double, double, uint32_t = 1);
+
+// Count to norm from counts of rational primes mod 4, without any sieve.
+uint64_t gPrimesToNormCountRational(uint64_t);
 uint64_t gPrimesInBlockCount(uint32_t, uint32_t, uint32_t, uint32_t);
 
-// Return pointer that can be shared with numpy to build np.arrays.
-// The first element of the pair holds a pointer to an array of uint32_t ints,
-// and the second element of the pair holds the size of the array.
-// Real parts and imaginary parts are concatenated together into the array;
-// they can be untangled in numpy as needed.
-pair<int32_t *, uint64_t> gPrimesToNormAsArray(uint64_t);
-pair<int32_t *, uint64_t> gPrimesInSectorAsArray(uint64_t, double, double);
-pair<int32_t *, uint64_t> gPrimesInBlockAsArray(uint32_t, uint32_t, uint32_t, uint32_t);
+// Sieve many blocks, each given as {x, y, dx, dy}, sharing one list of small
+// primes. The optional argument is a number of threads, 0 for all cores.
+vector<uint64_t> gPrimesInBlocksCount(const vector<vector<uint32_t>> &, uint32_t = 0);
+vector<GintArray> gPrimesInBlocksAsArrays(const vector<vector<uint32_t>> &, uint32_t = 0);
+
+// Return arrays that numpy takes ownership of, each prime a row of two int32.
+GintArray gPrimesToNormAsArray(uint64_t, uint32_t = 1);
+GintArray gPrimesInSectorAsArray(uint64_t, double, double, uint32_t = 1);
+GintArray gPrimesInBlockAsArray(uint32_t, uint32_t, uint32_t, uint32_t);
 
-// Histogram of angles of primes to norm.
-vector<uint64_t> angularDistribution(uint64_t, uint32_t);
+// Take the next prime in order of norm from an endless NormOrderedPrimes.
+pair<int32_t, int32_t> nextGPrimeByNorm(NormOrderedPrimes &);
 
-// Gather sector race data and store within class.
+// Stream primes to norm, or in a block, in chunks of the given size, sieved on
+// a producer thread at most two chunks ahead of the consumer; primes come in
+// sieve order. The stream is deleted by the caller, which stops the producer.
+PrimeStream *streamGPrimesToNorm(uint64_t, uint64_t);
+PrimeStream *streamGPrimesInBlock(uint32_t, uint32_t, uint32_t, uint32_t, uint64_t);
+GintArray nextGPrimeChunk(PrimeStream &); // empty once the stream is over
+
+// Keep the small primes shared by every sieve in a cache file; empty for none.
+// This is the one switch for the whole process, unlike setSmallPrimesFromFile
+// of a single sieve.
+void setPrimesCache(const string &);
+
+// Histogram of angles of primes with x1 <= norm <= x2 in the first octant,
+// below the diagonal, in sectors of equal angle; 0 threads uses them all.
+vector<uint64_t> angularDistribution(uint64_t, uint64_t, uint32_t, uint32_t);
+
+// Gather sector race data and store within class. Both sectors are sieved in
+// one pass by SectorRaces; their primes are only kept when asked for.
 class SectorRace
 {
 private:
-  uint64_t x, nBins;
   vector<gint> firstSector, secondSector;
-  vector<int32_t> normData;
+  vector<int64_t> normData;
 
 public:
-  SectorRace(uint64_t, uint64_t, long double, long double, long double, long double);
-  void setNormData();
-  pair<int32_t *, uint64_t> getFirstSector();
-  pair<int32_t *, uint64_t> getSecondSector();
-  int32_t *getNormData();
+  SectorRace(uint64_t, uint64_t, long double, long double, long double, long double, uint32_t = 1, bool = true);
+  GintArray getFirstSector();
+  GintArray getSecondSector();
+  vector<int64_t> getNormData();
 };
 
+// Norm data of many races at once, each given by alpha, beta, gamma, delta;
+// every prime is sieved once, and none is kept.
+vector<vector<int64_t>> sectorRacesNormData(uint64_t, uint64_t, const vector<vector<long double>> &, uint32_t);
+
 // Functions to access various moat data
-pair<int32_t *, uint64_t> moatMainComponent(double);
-vector<pair<int32_t *, uint64_t>> moatComponentsToNorm(double, uint64_t);
-vector<pair<int32_t *, uint64_t>> moatComponentsInBlock(double, uint32_t, uint32_t, uint32_t, uint32_t);
+GintArray moatMainComponent(double);
+vector<GintArray> moatComponentsToNorm(double, uint64_t);
+vector<GintArray> moatComponentsInBlock(double, uint32_t, uint32_t, uint32_t, uint32_t);
 
 // A class to gather components within a block
 class BlockMoat : public BlockSieve
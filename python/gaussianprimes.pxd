@@ -2,7 +2,9 @@
 
 from libcpp.vector cimport vector
 from libcpp.pair cimport pair
-from libc.stdint cimport uint32_t, uint64_t, int32_t
+from libcpp.string cimport string
+from libcpp cimport bool as cbool
+from libc.stdint cimport uint32_t, uint64_t, int32_t, int64_t
 cimport numpy as np
 
 # work around for bug with pointers
@@ -10,26 +12,54 @@ cimport numpy as np
 ctypedef int32_t * intptr
 
 
-cdef extern from 'cython_bindings.hpp':
-  uint64_t gPrimesToNormCount(uint64_t)
-  uint64_t gPrimesInSectorCount(uint64_t, double, double)
-  uint64_t gPrimesInBlockCount(uint32_t, uint32_t, uint32_t, uint32_t)
+# The module calls these with the GIL released, so sieves in different python
+# threads run at the same time; the C++ side keeps no unguarded shared state.
+cdef extern from 'cython_bindings.hpp' nogil:
+  # Primes handed over to numpy, which frees them with freeGintArray(owner)
+  cdef struct GintArray:
+    intptr data
+    uint64_t size
+    void *owner
+  void freeGintArray(void *)
 
-  pair[intptr, uint64_t] gPrimesToNormAsArray(uint64_t)
-  pair[intptr, uint64_t] gPrimesInSectorAsArray(uint64_t, long double, long double)
-  pair[intptr, uint64_t] gPrimesInBlockAsArray(uint32_t, uint32_t, uint32_t, uint32_t)
+  uint64_t gPrimesToNormCount(uint64_t, uint32_t) except +
+  uint64_t gPrimesToNormCountRational(uint64_t) except +
+  uint64_t gPrimesInSectorCount(uint64_t, double, double, uint32_t) except +
+  uint64_t gPrimesInBlockCount(uint32_t, uint32_t, uint32_t, uint32_t) except +
+  vector[uint64_t] gPrimesInBlocksCount(vector[vector[uint32_t]], uint32_t) except +
 
-  vector[uint64_t] angularDistribution(uint64_t, uint32_t)
+  GintArray gPrimesToNormAsArray(uint64_t, uint32_t) except +
+  GintArray gPrimesInSectorAsArray(uint64_t, long double, long double, uint32_t) except +
+  GintArray gPrimesInBlockAsArray(uint32_t, uint32_t, uint32_t, uint32_t) except +
+  vector[GintArray] gPrimesInBlocksAsArrays(vector[vector[uint32_t]], uint32_t) except +
+
+  vector[uint64_t] angularDistribution(uint64_t, uint64_t, uint32_t, uint32_t) except +
+
+  # Endless source of primes in order of norm, sieved one annulus at a time
+  cdef cppclass NormOrderedPrimes:
+    NormOrderedPrimes(uint64_t, uint64_t) except +
+  pair[int32_t, int32_t] nextGPrimeByNorm(NormOrderedPrimes &) except +
+
+  # Chunks of primes sieved on a producer thread a little ahead of the consumer
+  cdef cppclass PrimeStream:
+    pass
+  PrimeStream *streamGPrimesToNorm(uint64_t, uint64_t) except +
+  PrimeStream *streamGPrimesInBlock(uint32_t, uint32_t, uint32_t, uint32_t, uint64_t) except +
+  GintArray nextGPrimeChunk(PrimeStream &) except +
+
+  # Cache file for the small primes shared by every sieve
+  void setPrimesCache(const string &) except +
 
   # Using this class to transfer race data to numpy
   cdef cppclass SectorRace:
     SectorRace() except +
-    SectorRace(uint64_t, uint64_t, long double, long double, long double, long double) except +
-    pair[intptr, uint64_t] getFirstSector()
-    pair[intptr, uint64_t] getSecondSector()
-    intptr getNormData()
+    SectorRace(uint64_t, uint64_t, long double, long double, long double, long double, uint32_t, cbool) except +
+    GintArray getFirstSector() except +
+    GintArray getSecondSector() except +
+    vector[int64_t] getNormData() except +
+  vector[vector[int64_t]] sectorRacesNormData(uint64_t, uint64_t, vector[vector[long double]], uint32_t) except +
 
   # Functions accessing moat data
-  pair[intptr, uint64_t] moatMainComponent(double)
-  vector[pair[intptr, uint64_t]] moatComponentsToNorm(double, uint64_t)
-  vector[pair[intptr, uint64_t]] moatComponentsInBlock(double, int32_t, int32_t, int32_t, int32_t)
\ No newline at end of file
+  GintArray moatMainComponent(double) except +
+  vector[GintArray] moatComponentsToNorm(double, uint64_t) except +
+  vector[GintArray] moatComponentsInBlock(double, int32_t, int32_t, int32_t, int32_t) except +
\ No newline at end of file
@@ -2,32 +2,51 @@
 
 from libcpp.vector cimport vector
 from libcpp.pair cimport pair
-from libc.stdint cimport uint32_t, uint64_t, int32_t
+from libcpp.string cimport string
+from libcpp cimport bool as cbool
+from libc.stdint cimport uint32_t, uint64_t, int32_t, int64_t
 import math
-from cython cimport view
+import os
+import threading
+from concurrent.futures import ThreadPoolExecutor
+from cpython.pycapsule cimport PyCapsule_New, PyCapsule_GetPointer
 import matplotlib.pyplot as plt
 import numpy as np
 cimport numpy as cnp
 cimport gaussianprimes as gp
 
 
-cdef cnp.ndarray ptr_to_np_array(pair[intptr, uint64_t] p):
-  """Unpack a C++ pair holding a pointer and size into a 2D numpy array of unsigned longs."""
-  cdef intptr ptr = p.first
-  cdef uint64_t size = p.second
-  # casting to a memory view object
-  if size == 0:
-    return np.array([]).reshape(2, 0)
-  cdef view.array a = <cnp.int32_t[:size] > ptr
-  # De-flattening and chaining methods to get 2d numpy array.
-  return np.asarray(a).reshape(size // 2, 2).transpose()
+cnp.import_array()
 
 
-cpdef count(x: int):
+cdef void free_gint_array(object capsule) noexcept:
+  """Free the C++ vector holding the data of an array made by gint_array_to_np."""
+  gp.freeGintArray(PyCapsule_GetPointer(capsule, NULL))
+
+
+cdef cnp.ndarray gint_array_to_np(gp.GintArray p):
+  """Wrap primes passed from C++ in a 2D numpy array of int32, without copying.
+
+  The (n, 2) array of real and imaginary parts takes ownership of the C++
+  buffer, which is freed along with the array; it is returned transposed, as
+  the (2, n) view used throughout this module.
+  """
+  cdef cnp.npy_intp shape[2]
+  shape[0] = p.size
+  shape[1] = 2
+  cdef cnp.ndarray a = cnp.PyArray_SimpleNewFromData(2, shape, cnp.NPY_INT32, p.data)
+  cnp.set_array_base(a, PyCapsule_New(p.owner, NULL, free_gint_array))
+  return a.transpose()
+
+
+cpdef count(x: int, threads: int=1, rational: bool=False):
   """Count Gaussian primes, including associates, up to norm x.
 
   Args:
       x (int): Norm bound
+      threads (int): Number of sieving threads, 0 for all cores, default 1
+      rational (bool): Count rational primes mod 4 instead of sieving; much
+          faster for large x, threads is then ignored, default False
 
   Returns:
       int: Count of Gaussian primes
@@ -35,16 +54,26 @@ cpdef count(x: int):
   Raises:
       OverflowError: If x cannot be cast to uint64
   """
-  return gp.gPrimesToNormCount(x)
+  cdef uint64_t c_x = x
+  cdef uint32_t c_threads = threads
+  cdef bint c_rational = rational
+  cdef uint64_t result
+  with nogil:
+    if c_rational:
+      result = gp.gPrimesToNormCountRational(c_x)
+    else:
+      result = gp.gPrimesToNormCount(c_x, c_threads)
+  return result
 
 
-cpdef count_sector(x: int, alpha: float, beta: float):
+cpdef count_sector(x: int, alpha: float, beta: float, threads: int=1):
   """Count Gaussian primes in sector bounded by rays at alpha and beta up to norm x.
 
   Args:
       x (int): Norm bound
       alpha (float): Angle, in radians, of initial ray
       beta (float): Angle, in radians, of terminal ray
+      threads (int): Number of sieving threads, 0 for all cores, default 1
 
   Returns:
       int: Count of Gaussian primes
@@ -56,8 +85,14 @@ cpdef count_sector(x: int, alpha: float, beta: float):
   if min(alpha, beta) < 0 or max(alpha, beta) > math.pi / 2:
     raise NotImplementedError(
         'Only implemented for alpha >= 0 and beta < pi/2.')
-  # SectorSieve automatically assigns alpha to smaller and beta to larger
-  return gp.gPrimesInSectorCount(x, alpha, beta)
+  cdef uint64_t c_x = x
+  cdef double c_alpha = alpha, c_beta = beta
+  cdef uint32_t c_threads = threads
+  cdef uint64_t result
+  # SectorDonutSieve automatically assigns alpha to smaller and beta to larger
+  with nogil:
+    result = gp.gPrimesInSectorCount(c_x, c_alpha, c_beta, c_threads)
+  return result
 
 
 cpdef count_block(x: int, y: int, dx: int, dy: int):
@@ -75,14 +110,44 @@ cpdef count_block(x: int, y: int, dx: int, dy: int):
   Raises:
       OverflowError: If x, y, dx, or dy cannot be cast to uint32
   """
-  return gp.gPrimesInBlockCount(x, y, dx, dy)
+  cdef uint32_t c_x = x, c_y = y, c_dx = dx, c_dy = dy
+  cdef uint64_t result
+  with nogil:
+    result = gp.gPrimesInBlockCount(c_x, c_y, c_dx, c_dy)
+  return result
 
 
-cpdef gprimes(x: int):
+cpdef count_blocks(blocks, threads: int=0):
+  """Count Gaussian primes in each of many blocks [x, x + dx) x [y, y + dy).
+
+  The small primes are found once for the whole batch, and the blocks are
+  sieved on a pool of threads.
+
+  Args:
+      blocks (list): Blocks given as tuples (x, y, dx, dy)
+      threads (int): Number of sieving threads, 0 for all cores, default 0
+
+  Returns:
+      list[int]: Count of Gaussian primes in each block, in the given order
+
+  Raises:
+      OverflowError: If some x, y, dx, or dy cannot be cast to uint32
+      ValueError: If some block does not have four entries
+  """
+  cdef vector[vector[uint32_t]] c_blocks = [list(block) for block in blocks]
+  cdef uint32_t c_threads = threads
+  cdef vector[uint64_t] result
+  with nogil:
+    result = gp.gPrimesInBlocksCount(c_blocks, c_threads)
+  return result
+
+
+cpdef gprimes(x: int, threads: int=1):
   """Return Gaussian primes in first quadrant up to norm x.
 
   Args:
       x (int): Norm bound
+      threads (int): Number of sieving threads, 0 for all cores, default 1
 
   Returns:
       Gints: Array of Gaussian primes
@@ -90,18 +155,23 @@ cpdef gprimes(x: int):
   Raises:
       OverflowError: If x cannot be cast to uint64
   """
-  p = gp.gPrimesToNormAsArray(x)
-  np_primes = ptr_to_np_array(p)
+  cdef uint64_t c_x = x
+  cdef uint32_t c_threads = threads
+  cdef gp.GintArray p
+  with nogil:
+    p = gp.gPrimesToNormAsArray(c_x, c_threads)
+  np_primes = gint_array_to_np(p)
   return Gints(np_primes, x)
 
 
-cpdef gprimes_sector(x: int, alpha: float, beta: float):
+cpdef gprimes_sector(x: int, alpha: float, beta: float, threads: int=1):
   """Return Gaussian primes in sector bounded by rays at alpha and beta up to norm x.
 
   Args:
       x (int): Norm bound
       alpha (float): Angle, in radians, of initial ray
       beta (float): Angle, in radians, of terminal ray
+      threads (int): Number of sieving threads, 0 for all cores, default 1
 
   Returns:
       Gints: Array of Gaussian primes
@@ -113,9 +183,14 @@ cpdef gprimes_sector(x: int, alpha: float, beta: float):
   if min(alpha, beta) < 0 or max(alpha, beta) > math.pi / 2:
     raise NotImplementedError(
         'Only implemented for alpha >= 0 and beta < pi/2.')
-  # SectorSieve automatically assigns alpha to smaller and beta to larger
-  p = gp.gPrimesInSectorAsArray(x, alpha, beta)
-  np_primes = ptr_to_np_array(p)
+  cdef uint64_t c_x = x
+  cdef long double c_alpha = alpha, c_beta = beta
+  cdef uint32_t c_threads = threads
+  cdef gp.GintArray p
+  # SectorDonutSieve automatically assigns alpha to smaller and beta to larger
+  with nogil:
+    p = gp.gPrimesInSectorAsArray(c_x, c_alpha, c_beta, c_threads)
+  np_primes = gint_array_to_np(p)
   return Gints(np_primes, x, alpha, beta)
 
 
@@ -134,26 +209,246 @@ cpdef gprimes_block(x: int, y: int, dx: int, dy: int):
   Raises:
       OverflowError: If x, y, dx, or dy cannot be cast to uint32
   """
-  p = gp.gPrimesInBlockAsArray(x, y, dx, dy)
-  np_primes = ptr_to_np_array(p)
+  cdef uint32_t c_x = x, c_y = y, c_dx = dx, c_dy = dy
+  cdef gp.GintArray p
+  with nogil:
+    p = gp.gPrimesInBlockAsArray(c_x, c_y, c_dx, c_dy)
+  np_primes = gint_array_to_np(p)
   return Gints(np_primes, x, y, dx, dy)
 
 
-cpdef angular_dist(x: int, n: int, ignore_outliers: bool=True):
-  """Create histogram of Gaussian primes up to norm x in n equal-spaced sectors.
+cpdef gprimes_blocks(blocks, threads: int=0):
+  """Return Gaussian primes in each of many blocks [x, x + dx) x [y, y + dy).
+
+  The small primes are found once for the whole batch, and the blocks are
+  sieved on a pool of threads.
+
+  Args:
+      blocks (list): Blocks given as tuples (x, y, dx, dy)
+      threads (int): Number of sieving threads, 0 for all cores, default 0
+
+  Returns:
+      list[Gints]: Array of Gaussian primes in each block, in the given order
+
+  Raises:
+      OverflowError: If some x, y, dx, or dy cannot be cast to uint32
+      ValueError: If some block does not have four entries
+  """
+  blocks = [list(block) for block in blocks]
+  cdef vector[vector[uint32_t]] c_blocks = blocks
+  cdef uint32_t c_threads = threads
+  # Cython compiler gets confused if this isn't explicitly typed
+  cdef vector[gp.GintArray] vector_of_ptrs
+  with nogil:
+    vector_of_ptrs = gp.gPrimesInBlocksAsArrays(c_blocks, c_threads)
+  arrays = []
+  for i in range(vector_of_ptrs.size()):
+    x, y, dx, dy = blocks[i]
+    np_primes = gint_array_to_np(vector_of_ptrs[i])
+    arrays.append(Gints(np_primes, x, y, dx, dy))
+  return arrays
+
+
+def gprimes_by_norm(start: int=0, width: int=2 ** 22):
+  """Yield Gaussian primes in first quadrant in order of norm, without a norm bound.
+
+  Norms are sieved in successive annuli [start, start + width), [start + width,
+  start + 2 * width), ..., so memory use does not grow with the number of primes
+  taken.
+
+  Args:
+      start (int): Smallest norm, default 0
+      width (int): Width of each sieved annulus, default 2 ** 22
+
+  Yields:
+      tuple[int, int]: Real and imaginary parts of the next Gaussian prime
+
+  Raises:
+      OverflowError: If start or width cannot be cast to uint64
+  """
+  cdef gp.NormOrderedPrimes *primes = new gp.NormOrderedPrimes(start, width)
+  cdef pair[int32_t, int32_t] g
+  try:
+    while True:
+      # Most calls return at once, but some sieve the next annulus.
+      with nogil:
+        g = gp.nextGPrimeByNorm(primes[0])
+      yield g
+  finally:
+    del primes
+
+
+def iter_gprimes(x: int, chunk_size: int=2 ** 20):
+  """Yield Gaussian primes in first quadrant up to norm x in chunks, as they are sieved.
+
+  The octant is sieved one tile at a time on a C++ thread that runs at most two
+  chunks ahead of the consumer, so memory stays at a few chunks however large x
+  is, and sieving overlaps with the processing of earlier chunks. Within and
+  across chunks, primes come in sieve order rather than by norm; together they
+  are the primes of gprimes(x).
+
+  Args:
+      x (int): Norm bound
+      chunk_size (int): Number of primes per chunk; the last may hold fewer
+
+  Yields:
+      Gints: Array of Gaussian primes
+
+  Raises:
+      OverflowError: If x or chunk_size cannot be cast to uint64
+  """
+  cdef uint64_t c_x = x, c_chunk_size = chunk_size
+  cdef gp.PrimeStream *stream = gp.streamGPrimesToNorm(c_x, c_chunk_size)
+  cdef gp.GintArray p
+  try:
+    while True:
+      with nogil:
+        p = gp.nextGPrimeChunk(stream[0])
+      if p.size == 0:
+        gp.freeGintArray(p.owner)
+        return
+      yield Gints(gint_array_to_np(p), x)
+  finally:
+    # Stopping the producer may wait for it to finish its current tile.
+    with nogil:
+      del stream
+
+
+def iter_gprimes_block(x: int, y: int, dx: int, dy: int, chunk_size: int=2 ** 20):
+  """Yield Gaussian primes in the block [x, x + dx) x [y, y + dy) in chunks.
+
+  The block is sieved on a C++ thread, and its primes are gathered column by
+  column at most two chunks ahead of the consumer; see iter_gprimes.
+
+  Args:
+      x (int): Real coordinate of lower left corner
+      y (int): Imaginery coordinate of lower left corner
+      dx (int): Block width
+      dy (int): Block height
+      chunk_size (int): Number of primes per chunk; the last may hold fewer
+
+  Yields:
+      Gints: Array of Gaussian primes
+
+  Raises:
+      OverflowError: If x, y, dx, or dy cannot be cast to uint32
+  """
+  cdef uint32_t c_x = x, c_y = y, c_dx = dx, c_dy = dy
+  cdef uint64_t c_chunk_size = chunk_size
+  cdef gp.PrimeStream *stream = gp.streamGPrimesInBlock(c_x, c_y, c_dx, c_dy, c_chunk_size)
+  cdef gp.GintArray p
+  try:
+    while True:
+      with nogil:
+        p = gp.nextGPrimeChunk(stream[0])
+      if p.size == 0:
+        gp.freeGintArray(p.owner)
+        return
+      yield Gints(gint_array_to_np(p), x, y, dx, dy)
+  finally:
+    with nogil:
+      del stream
+
+
+cpdef set_primes_cache(path):
+  """Keep the small primes used by every sieve in a cache file.
+
+  The primes are read from the file when it reaches far enough, instead of
+  being sieved again, and the file is rewritten whenever more are sieved. The
+  environment variable GINT_PRIMES_CACHE gives the file when this is not called.
+  The file is used by every sieve of the process from then on.
+
+  Args:
+      path (str): Path of the cache file, or None to stop using one
+  """
+  cdef string c_path = b'' if path is None else os.fsencode(path)
+  with nogil:
+    gp.setPrimesCache(c_path)
+
+
+# Pool shared by the *_async functions, started on first use.
+_executor = None
+_executor_lock = threading.Lock()
+
+
+def _submit(f, *args):
+  """Run f(*args) on the shared pool, returning a concurrent.futures.Future."""
+  global _executor
+  with _executor_lock:
+    if _executor is None:
+      _executor = ThreadPoolExecutor(max_workers=os.cpu_count(),
+                                     thread_name_prefix='gaussianprimes')
+  return _executor.submit(f, *args)
+
+
+def count_async(x: int, threads: int=1, rational: bool=False):
+  """Start count(x, threads, rational) on a worker thread.
+
+  Sieves release the GIL, so futures from this and the other *_async functions
+  run at the same time as each other and as the calling thread. In asyncio,
+  await asyncio.wrap_future(count_async(x)).
+
+  Returns:
+      concurrent.futures.Future: Resolves to the result of count
+  """
+  return _submit(count, x, threads, rational)
+
+
+def count_sector_async(x: int, alpha: float, beta: float, threads: int=1):
+  """Start count_sector(x, alpha, beta, threads) on a worker thread; see count_async."""
+  return _submit(count_sector, x, alpha, beta, threads)
+
+
+def count_block_async(x: int, y: int, dx: int, dy: int):
+  """Start count_block(x, y, dx, dy) on a worker thread; see count_async."""
+  return _submit(count_block, x, y, dx, dy)
+
+
+def gprimes_async(x: int, threads: int=1):
+  """Start gprimes(x, threads) on a worker thread; see count_async."""
+  return _submit(gprimes, x, threads)
+
+
+def gprimes_sector_async(x: int, alpha: float, beta: float, threads: int=1):
+  """Start gprimes_sector(x, alpha, beta, threads) on a worker thread; see count_async."""
+  return _submit(gprimes_sector, x, alpha, beta, threads)
+
+
+def gprimes_block_async(x: int, y: int, dx: int, dy: int):
+  """Start gprimes_block(x, y, dx, dy) on a worker thread; see count_async."""
+  return _submit(gprimes_block, x, y, dx, dy)
+
+
+cpdef angular_dist(x: int, n: int, ignore_outliers: bool=True, start: int=0, threads: int=1):
+  """Create histogram of Gaussian primes with start <= norm <= x in n equal-spaced sectors.
+
+  The sectors split the first octant below the diagonal, and sector k holds the
+  primes with k pi / 4n <= angle < (k + 1) pi / 4n. Primes are binned while they
+  are sieved and never held, so the window of norms may hold more primes than
+  fit in memory.
 
   Args:
       x (int): Norm bound
       n (int): Number of bins
       ignore_outliers (bool): Ignore histogram outliers, default True
+      start (int): Lower norm bound, default 0
+      threads (int): Number of threads sieving annuli of the window; 0 uses all, default 1
 
   Returns:
       np.array: Array of histogram counts
 
   Raises:
-      OverflowError: If x cannot be cast to uint64 or n cannot be cast to uint32
+      OverflowError: If x or start cannot be cast to uint64 or n or threads cannot be cast to uint32
+      ValueError: If n is 0 or start exceeds x
   """
-  data = np.array(gp.angularDistribution(x, n))
+  cdef uint64_t c_x1 = start
+  cdef uint64_t c_x2 = x
+  cdef uint32_t c_n = n
+  cdef uint32_t c_threads = threads
+  cdef vector[uint64_t] counts
+  with nogil:
+    counts = gp.angularDistribution(c_x1, c_x2, c_n, c_threads)
+  data = np.array(counts)
   m0 = np.percentile(data, 1)
   m1 = np.percentile(data, 99)
   plt.subplots(figsize=(12, 8))
@@ -184,8 +479,11 @@ cpdef moat_component(jump_size: float):
   if jump_size > 5:
     raise OverflowError('Cannot handle jump_size > 5.')
 
-  p = gp.moatMainComponent(jump_size)
-  np_primes = ptr_to_np_array(p)
+  cdef double c_jump_size = jump_size
+  cdef gp.GintArray p
+  with nogil:
+    p = gp.moatMainComponent(c_jump_size)
+  np_primes = gint_array_to_np(p)
   # In cython_bindings.cpp, appending the largest element to the end of the array
   # Here, getting its value so we can pass it to the Gints class
   x = np_primes[0][-1] ** 2 + np_primes[1][-1] ** 2
@@ -211,12 +509,16 @@ cpdef moat_components_to_norm(jump_size: float, x: int):
   if jump_size > 5:
     raise OverflowError('Cannot handle jump_size > 5.')
 
+  cdef double c_jump_size = jump_size
+  cdef uint64_t c_x = x
   # Cython compiler gets confused if this isn't explicitly typed
-  cdef vector[pair[intptr, uint64_t]] vector_of_ptrs = gp.moatComponentsToNorm(jump_size, x)
+  cdef vector[gp.GintArray] vector_of_ptrs
+  with nogil:
+    vector_of_ptrs = gp.moatComponentsToNorm(c_jump_size, c_x)
   components = []
   for i in range(vector_of_ptrs.size()):
     p = vector_of_ptrs[i]
-    np_primes = ptr_to_np_array(p)
+    np_primes = gint_array_to_np(p)
     components.append(np_primes)
   return components
 
@@ -238,12 +540,16 @@ cpdef moat_components_in_block(jump_size: float, x: int, y: int, dx: int, dy: in
   Raises:
       OverflowError: If x, y, dx, dy cannot be cast to uint32
   """
+  cdef double c_jump_size = jump_size
+  cdef int32_t c_x = x, c_y = y, c_dx = dx, c_dy = dy
   # Cython compiler gets confused if this isn't explicitly typed
-  cdef vector[pair[intptr, uint64_t]] vector_of_ptrs = gp.moatComponentsInBlock(jump_size, x, y, dx, dy)
+  cdef vector[gp.GintArray] vector_of_ptrs
+  with nogil:
+    vector_of_ptrs = gp.moatComponentsInBlock(c_jump_size, c_x, c_y, c_dx, c_dy)
   components = []
   for i in range(vector_of_ptrs.size()):
     p = vector_of_ptrs[i]
-    np_primes = ptr_to_np_array(p)
+    np_primes = gint_array_to_np(p)
     components.append(np_primes)
 
   # Crudely passed edge data as last component; now crudely dealing with it
@@ -260,6 +566,37 @@ cpdef moat_components_in_block(jump_size: float, x: int, y: int, dx: int, dy: in
   return components, segments
 
 
+cpdef race_norm_data(x: int, races, n_bins: int=1000, threads: int=1):
+  """Norm data of many sector races at once, as in Race.norm_data.
+
+  Every sector is sieved in a single pass, with overlapping sectors sieved once
+  as one enclosing sector, and no prime is kept; memory does not grow with the
+  number of primes.
+
+  Args:
+      x (int): Norm bound
+      races: Sequence of (alpha, beta, gamma, delta), each racing the sector
+          alpha <= angle < beta against gamma <= angle < delta
+      n_bins (int): Number of norm bins. Defaults to 1000.
+      threads (int): Number of sieving threads, 0 for all cores. Defaults to 1.
+
+  Returns:
+      np.array: Array of shape (len(races), n_bins); entry [k, i] is the first
+      count minus the second in race k for norms below (i + 1) x / n_bins,
+      or up to x in the last bin
+
+  Raises:
+      ValueError: If a race is not four angles in [0, pi/2], or x or n_bins is 0
+  """
+  cdef uint64_t c_x = x, c_n_bins = n_bins
+  cdef uint32_t c_threads = threads
+  cdef vector[vector[long double]] c_races = [[float(angle) for angle in race] for race in races]
+  cdef vector[vector[int64_t]] data
+  with nogil:
+    data = gp.sectorRacesNormData(c_x, c_n_bins, c_races, c_threads)
+  return np.array(data, dtype=np.int64).reshape(len(races), n_bins)
+
+
 class Race:
   """Wrapper class to hold data from Gaussian prime races.
 
@@ -270,6 +607,9 @@ class Race:
       gamma (float): Initial angle for second sector.
       delta (float): Terminal angle for second sector.
       n_bins (int): Number of histogram bins. Defaults to 1000.
+      threads (int): Number of sieving threads, 0 for all cores. Defaults to 1.
+      keep_primes (bool): Keep the primes of both sectors in sector1 and sector2,
+          as plot_sectors needs; otherwise only the race is tallied. Defaults to True.
 
   Raises:
       NotImplementedError: If the angles are not in the interval [0, p/4)
@@ -284,7 +624,9 @@ class Race:
       beta: float,
       gamma: float,
       delta: float,
-      n_bins: int = 1000
+      n_bins: int = 1000,
+      threads: int = 1,
+      keep_primes: bool = True
   ):
     if alpha > beta or gamma > delta:
       raise ValueError('The four angle measures must be increasing.')
@@ -307,21 +649,24 @@ class Race:
     self.normalize = normalizer(self.norms)
 
     # Taking what is needed from cpp class
-    race = new gp.SectorRace(x, n_bins, alpha, beta, gamma, delta)
-
-    s = race.getFirstSector()
-    self.sector1 = ptr_to_np_array(s)
-
-    s = race.getSecondSector()
-    self.sector2 = ptr_to_np_array(s)
-
-    cdef int32_t * race_ptr = race.getNormData()
-    # casting to a memory view object
-    cdef view.array norm_data = <cnp.int32_t[:n_bins] > race_ptr
-    self.norm_data = np.asarray(norm_data)
-
-    # Deleting cpp instance; not sure if this is useful.
-    del race
+    cdef uint64_t c_x = x, c_n_bins = n_bins
+    cdef long double c_alpha = alpha, c_beta = beta, c_gamma = gamma, c_delta = delta
+    cdef uint32_t c_threads = threads
+    cdef cbool c_keep_primes = keep_primes
+    cdef gp.SectorRace *race
+    with nogil:
+      race = new gp.SectorRace(c_x, c_n_bins, c_alpha, c_beta, c_gamma, c_delta, c_threads, c_keep_primes)
+
+    try:
+      s = race.getFirstSector()
+      self.sector1 = gint_array_to_np(s)
+
+      s = race.getSecondSector()
+      self.sector2 = gint_array_to_np(s)
+
+      self.norm_data = np.array(race.getNormData(), dtype=np.int64)
+    finally:
+      del race
 
   def plot_race(self, normalize: bool = True):
     """Plot norms against the difference pi(sector1) - pi(sector2)."""
@@ -29,6 +29,15 @@ def test_count_gprimes():
   assert gp.count(8) == 12
   assert gp.count(9) == 16
 
+  assert gp.count(10 ** 8, threads=4) == 23046512
+  assert gp.count(10 ** 9, threads=0) == 203394764
+  assert gp.count(9, threads=2) == 16
+
+  assert gp.count(10 ** 9, rational=True) == 203394764
+  assert gp.count(10 ** 12, rational=True) == 150431552012
+  for x in range(2000):
+    assert gp.count(x, rational=True) == gp.count(x)
+
   try:
     gp.count(-1)
     raise ValueError
@@ -65,12 +74,23 @@ def test_gprimes():
   g = gp.gprimes(0)
   assert g.shape == (2, 0)
 
+  # The (n, 2) buffer passed from C++ is viewed, not copied, and outlives g.
+  g = gp.gprimes(1000)
+  t = np.asarray(g).T
+  assert t.dtype == np.int32 and t.flags['C_CONTIGUOUS'] and not t.flags['OWNDATA']
+  del g
+  assert (t[:4] == [[1, 1], [2, 1], [1, 2], [3, 0]]).all()
+
   g = gp.gprimes(10)
   g = np.asarray(g)
   a = np.array([[1, 1], [2, 1], [1, 2], [3, 0]])
   a = a.transpose()
   assert (g == a).all()
 
+  g = gp.gprimes(10 ** 6)
+  h = gp.gprimes(10 ** 6, threads=3)
+  assert (np.asarray(g) == np.asarray(h)).all()
+
   try:
     gp.gprimes(-1)
     raise ValueError
@@ -84,6 +104,25 @@ def test_gprimes():
     pass
 
 
+def test_gprimes_by_norm():
+  """Test gprimes_by_norm against gprimes."""
+  x = 10 ** 6
+  g = np.asarray(gp.gprimes(x)).transpose().tolist()
+  for start, width in [(0, 10 ** 5), (0, 2 ** 22), (12345, 999)]:
+    h = []
+    for p in gp.gprimes_by_norm(start, width):
+      if p[0] ** 2 + p[1] ** 2 > x:
+        break
+      h.append(list(p))
+    assert h == [p for p in g if p[0] ** 2 + p[1] ** 2 >= start]
+
+  try:
+    next(gp.gprimes_by_norm(-1))
+    raise ValueError
+  except OverflowError:
+    pass
+
+
 def test_gprimes_block():
   """Test gprimes_block."""
   g = gp.gprimes_block(10000, 20000, 300, 400)
@@ -99,10 +138,119 @@ def test_gprimes_block():
   assert p == n
 
 
+def test_blocks():
+  """Test count_blocks and gprimes_blocks against the single block functions."""
+  blocks = [(10000 + 100 * i, 20000 + 50 * j, 100, 50) for i in range(4) for j in range(3)]
+  blocks.append((20785207 - 10, 0, 20, 10))
+  counts = gp.count_blocks(blocks, threads=3)
+  assert counts == [gp.count_block(*block) for block in blocks]
+  assert counts[-1] == 1
+  arrays = gp.gprimes_blocks(blocks)
+  for block, g in zip(blocks, arrays):
+    assert (np.asarray(g) == np.asarray(gp.gprimes_block(*block))).all()
+  try:
+    gp.count_blocks([(1, 2, 3)])
+    assert False
+  except ValueError:
+    pass
+
+
+def test_iter_gprimes():
+  """Test that the chunks of iter_gprimes and iter_gprimes_block make up gprimes."""
+  x = 10 ** 7
+  chunks = list(gp.iter_gprimes(x, chunk_size=10 ** 5))
+  assert all(c.shape == (2, 10 ** 5) for c in chunks[:-1])
+  g = np.concatenate([np.asarray(c) for c in chunks], axis=1)
+  expected = np.asarray(gp.gprimes(x))
+  assert g.shape == expected.shape
+  assert sorted(map(tuple, g.T)) == sorted(map(tuple, expected.T))
+  assert list(gp.iter_gprimes(1)) == []
+
+  block = (10 ** 6, 10 ** 6, 1000, 1000)
+  chunks = list(gp.iter_gprimes_block(*block, chunk_size=1000))
+  g = np.concatenate([np.asarray(c) for c in chunks], axis=1)
+  expected = np.asarray(gp.gprimes_block(*block))
+  assert sorted(map(tuple, g.T)) == sorted(map(tuple, expected.T))
+
+  # Leaving the generator early stops the sieve.
+  for c in gp.iter_gprimes(10 ** 14, chunk_size=1000):
+    assert c.shape == (2, 1000)
+    break
+
+
+def test_primes_cache(tmp_path):
+  """Test that sieves give the same primes with a cache file."""
+  path = tmp_path / 'primes.cache'
+  expected = gp.count(10 ** 9)
+  block = np.asarray(gp.gprimes_block(10 ** 6, 10 ** 6, 100, 100))
+  gp.set_primes_cache(str(path))
+  try:
+    # Reaching beyond every earlier sieve writes the cache.
+    assert gp.count_block(10 ** 8, 10 ** 8, 100, 100) == gp.gprimes_block(10 ** 8, 10 ** 8, 100, 100).shape[1]
+    assert path.exists()
+    assert gp.count(10 ** 9) == expected
+    assert (np.asarray(gp.gprimes_block(10 ** 6, 10 ** 6, 100, 100)) == block).all()
+  finally:
+    gp.set_primes_cache(None)
+
+
+def test_async():
+  """Test that concurrent futures give the same results as direct calls."""
+  futures = [gp.count_async(10 ** 8), gp.count_async(10 ** 8, threads=2),
+             gp.count_sector_async(10 ** 7, 0.1, 0.2),
+             gp.count_block_async(10 ** 6, 10 ** 6, 100, 100)]
+  assert [f.result() for f in futures] == [gp.count(10 ** 8)] * 2 + [
+      gp.count_sector(10 ** 7, 0.1, 0.2), gp.count_block(10 ** 6, 10 ** 6, 100, 100)]
+  g = gp.gprimes_async(10 ** 6)
+  s = gp.gprimes_sector_async(10 ** 6, 0.1, 0.2)
+  b = gp.gprimes_block_async(10 ** 6, 10 ** 6, 100, 100)
+  assert (np.asarray(g.result()) == np.asarray(gp.gprimes(10 ** 6))).all()
+  assert (np.asarray(s.result()) == np.asarray(gp.gprimes_sector(10 ** 6, 0.1, 0.2))).all()
+  assert (np.asarray(b.result()) == np.asarray(gp.gprimes_block(10 ** 6, 10 ** 6, 100, 100))).all()
+  try:
+    gp.count_async(-1).result()
+    assert False
+  except OverflowError:
+    pass
+
+
+def test_angular_dist():
+  """Test angular_dist against the angles of gprimes."""
+  a, b = np.asarray(gp.gprimes(10 ** 5))
+  counts = gp.angular_dist(10 ** 5, 20)
+  assert counts.sum() == ((0 <= b) & (b < a)).sum()
+  expected = np.bincount((20 * np.arctan2(b, a) / (np.pi / 4)).astype(int)[(0 <= b) & (b < a)], minlength=20)
+  assert (counts == expected).all()
+  outer = gp.angular_dist(10 ** 6, 20, start=10 ** 5 + 1, threads=3)
+  assert (counts + outer == gp.angular_dist(10 ** 6, 20)).all()
+
+
 def test_gprimes_sector():
   """Test gprimes_sector."""
   g = gp.gprimes_sector(100000, 0.1, 0.2)
   verify_splitting(g)
+  h = gp.gprimes_sector(100000, 0.1, 0.2, threads=3)
+  assert (np.asarray(g) == np.asarray(h)).all()
+  assert gp.count_sector(10 ** 8, 0.1, 0.2, threads=4) == gp.count_sector(10 ** 8, 0.1, 0.2)
+
+
+def test_race():
+  """Test Race and race_norm_data against the primes of each sector."""
+  x = 10 ** 6
+  r = gp.Race(x, 0.1, 0.2, 0.5, 0.6, n_bins=100, threads=2)
+  n1 = np.sort((r.sector1.astype(np.int64) ** 2).sum(axis=0))
+  n2 = np.sort((r.sector2.astype(np.int64) ** 2).sum(axis=0))
+  assert len(n1) == gp.count_sector(x, 0.1, 0.2)
+  assert len(n2) == gp.count_sector(x, 0.5, 0.6)
+  bins = np.arange(1, 101) * x // 100
+  expected = np.searchsorted(n1, bins) - np.searchsorted(n2, bins)
+  assert (r.norm_data == expected).all()
+  assert (gp.Race(x, 0.1, 0.2, 0.5, 0.6, n_bins=100, keep_primes=False).norm_data == expected).all()
+
+  data = gp.race_norm_data(x, [(0.1, 0.2, 0.5, 0.6), (0.1, 0.2, 0.15, 0.25), (0.3, 0.4, 0.3, 0.4)], 100, threads=3)
+  assert data.shape == (3, 100)
+  assert (data[0] == expected).all()
+  assert (data[2] == 0).all()
 
 
 def test_moat():
@@ -138,7 +286,13 @@ if __name__ == '__main__':
   test_count_gprimes()
   test_count_block()
   test_gprimes()
+  test_gprimes_by_norm()
+  test_iter_gprimes()
   test_gprimes_block()
+  test_blocks()
+  test_async()
+  test_angular_dist()
+  test_race()
   test_gprimes_sector()
   test_moat()
   test_readme_examples()
@@ -16,9 +16,23 @@ sources = [
     'src/cython_bindings.cpp',
     'src/BaseSieve.cpp',
     'src/OctantSieve.cpp',
+    'src/Presieve.cpp',
+    'src/NormSort.cpp',
     'src/OctantDonutSieve.cpp',
     'src/SectorSieve.cpp',
+    'src/SectorDonutSieve.cpp',
+    'src/SectorRaces.cpp',
     'src/BlockSieve.cpp',
+    'src/BlockDonutSieve.cpp',
+    'src/BlockBatch.cpp',
+    'src/SmallPrimes.cpp',
+    'src/PrimeStream.cpp',
+    'src/SegmentedDonutSieve.cpp',
+    'src/AnnulusSieve.cpp',
+    'src/AnnulusDonutSieve.cpp',
+    'src/AngularHistogram.cpp',
+    'src/NormOrderedPrimes.cpp',
+    'src/PrimeCounting.cpp',
     'src/OctantMoat.cpp'
 ]
 
@@ -31,8 +45,8 @@ extensions = [setuptools.Extension(
     'gaussianprimes',
     sources=sources,
     include_dirs=[np.get_include(), 'include'],
-    extra_compile_args=['-std=c++11', '-stdlib=libc++'],
-    extra_link_args=['-std=c++11', '-stdlib=libc++'],
+    extra_compile_args=['-std=c++14', '-stdlib=libc++', '-pthread'],
+    extra_link_args=['-std=c++14', '-stdlib=libc++', '-pthread'],
     language='c++'
 )]
 
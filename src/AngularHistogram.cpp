@@ -0,0 +1,136 @@
+/* Histogram of the angles of Gaussian primes without atan2. The boundaries of
+ * the bins are held as integer rays, as in SectorSieve, and a + bi lies in bin
+ * k exactly when it is on or above ray k and below ray k + 1, which is decided
+ * by cross products.
+ *
+ * To find k with a single lookup, the slope b / a in [0, 1) is cut into
+ * 2nBins slices of equal width. A bin is at least pi / 4nBins wide in angle,
+ * and so at least as wide in slope, since tan has slope at least 1; every slice
+ * thus meets at most two bins, and one cross product with the ray between
+ * them settles the bin. The slice is guessed in floating point and checked in
+ * integers, so the bin is exact; each prime reads one slice and one count.
+ *
+ * The window x1 <= norm <= x2 is cut into annuli of equal area, at least two
+ * per thread and none holding more than 2^32 norms, so each worker only ever
+ * holds the sieve array of a single annulus of bounded size.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include "AngularHistogram.hpp"
+#include "AnnulusDonutSieve.hpp"
+#include "Threads.hpp"
+using namespace std;
+
+AngularHistogram::AngularHistogram(uint64_t x1, uint64_t x2, uint32_t nBins, bool verbose, uint32_t threads)
+    : x1(x1),
+      x2(x2),
+      nBins(nBins),
+      verbose(verbose),
+      threads(threadCount(threads)),
+      smallPrimes(SmallPrimes::upTo(0))
+{
+  if (!nBins)
+  {
+    throw invalid_argument("The number of bins should be positive.");
+  }
+  if (x1 > x2)
+  {
+    throw invalid_argument("The inner norm x1 should not exceed the outer norm x2.");
+  }
+  vector<Ray> boundaries; // boundaries[k] is the ray at angle k pi / 4nBins
+  for (uint32_t k = 0; k <= nBins; k++)
+  {
+    boundaries.emplace_back(M_PI_4 * (long double)(k) / nBins);
+  }
+  // The point nSlices + i i starts slice i, so its bin is the lowest meeting
+  // it. Ray nBins is the diagonal, above every a + bi with b < a.
+  uint64_t nSlices = uint64_t(2) * nBins;
+  slices.resize(nSlices);
+  uint32_t k = 0;
+  for (uint64_t i = 0; i < nSlices; i++)
+  {
+    while ((k + 1 < nBins) && boundaries[k + 1].isOnOrAbove(nSlices, i))
+    {
+      k++;
+    }
+    slices[i] = {k, int64_t(boundaries[k + 1].p), int64_t(boundaries[k + 1].q)};
+  }
+}
+
+uint32_t AngularHistogram::binOf(gint g) const
+{
+  // Slice i holds the slopes with i <= nSlices b / a < i + 1.
+  int128_t nSlices = slices.size();
+  auto i = uint64_t(double(g.b) / g.a * slices.size());
+  i = min(i, uint64_t(slices.size() - 1));
+  while (i && (nSlices * g.b < int128_t(i) * g.a))
+  {
+    i--;
+  }
+  while ((i + 1 < slices.size()) && (nSlices * g.b >= int128_t(i + 1) * g.a))
+  {
+    i++;
+  }
+  const Slice &s = slices[i];
+  return s.bin + (int128_t(s.p) * g.b - int128_t(s.q) * g.a >= 0);
+}
+
+vector<uint64_t> AngularHistogram::getCounts()
+{
+  if (verbose)
+  {
+    cerr << "Taking smallPrimes from the shared table..." << endl;
+  }
+  smallPrimes = SmallPrimes::upTo(isqrt(x2));
+
+  vector<pair<uint64_t, uint64_t>> pieces = equalAreaAnnuli(x1, x2, threads);
+  if (verbose)
+  {
+    cerr << "Sieving " << pieces.size() << " annular piece(s) with " << threads
+         << " thread(s) and putting primes into " << nBins << " bins by angle..." << endl;
+  }
+
+  vector<vector<uint64_t>> histograms(threads, vector<uint64_t>(nBins, 0));
+  forEachOnThreads(threads, pieces.size(), [&](uint64_t k, uint32_t t) {
+    vector<uint64_t> &histogram = histograms[t];
+    AnnulusDonutSieve s(pieces[k].first, pieces[k].second, false);
+    s.setSieveArray();
+    uint32_t bound = isqrt(pieces[k].second);
+    for (gint g : smallPrimes)
+    {
+      if (g.norm() > bound)
+      {
+        break;
+      }
+      s.crossOffMultiples(g);
+    }
+    // Only the first octant below the diagonal is binned; the harvest
+    // also gives the flip of each prime.
+    s.visitBigPrimes([&](const vector<gint> &primes) {
+      for (gint g : primes)
+      {
+        if (g.b < g.a)
+        {
+          histogram[binOf(g)]++;
+        }
+      }
+    });
+  });
+
+  vector<uint64_t> counts(nBins, 0);
+  for (const vector<uint64_t> &histogram : histograms)
+  {
+    for (uint32_t k = 0; k < nBins; k++)
+    {
+      counts[k] += histogram[k];
+    }
+  }
+  if (verbose)
+  {
+    cerr << "Done binning.\n"
+         << endl;
+  }
+  return counts;
+}
@@ -0,0 +1,237 @@
+/* Perform sieving in the annulus of the first octant defined by x1 <= norm <= x2,
+ * keeping only the gints coprime to 10 as in OctantDonutSieve. Multiples of a
+ * small prime g are found through cofactors c + di in the first octant with
+ * norm between x1 / N(g) and x2 / N(g), as in AnnulusSieve, where d jumps
+ * through the donut residues for c mod 10. Every such multiple lies in the
+ * sieve array, whose words may stick out of the annulus; this is fixed when
+ * the primes are harvested.
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include "AnnulusDonutSieve.hpp"
+#include "SmallPrimes.hpp"
+#include "Presieve.hpp"
+using namespace std;
+
+constexpr Donut<10> AnnulusDonutSieve::donut;
+
+// Using an initializer list in the constructor.
+AnnulusDonutSieve::AnnulusDonutSieve(uint64_t x1, uint64_t x2, bool verbose)
+    : SieveTemplate<uint32_t>(x2, verbose), x1(x1), x2(x2), A0(0)
+{
+  if (x1 > x2)
+  {
+    throw invalid_argument("The inner norm x1 should not exceed the outer norm x2.");
+  }
+}
+
+void AnnulusDonutSieve::setSmallPrimes()
+{
+  if (verbose)
+  {
+    cerr << "Taking smallPrimes from the shared table..." << endl;
+  }
+  smallPrimes = SmallPrimes::upTo(isqrt(x2)).toVector();
+}
+
+// Column A holds the words B meeting x1 <= a^2 + b^2 <= x2 and b <= a for some
+// 10A <= a <= 10A + 9. The lowest is found at a = 10A + 9 and the highest is
+// bounded by both the diagonal and the outer circle at a = 10A.
+void AnnulusDonutSieve::setSieveArray()
+{
+  if (verbose)
+  {
+    cerr << "Building donut sieve array..." << endl;
+  }
+  A0 = ceilSqrt((x1 + 1) / 2) / 10;
+  heightShifts.clear();
+  vector<uint32_t> heights;
+  for (uint64_t A = A0; A <= isqrt(x2) / 10; A++)
+  {
+    uint64_t corner = 10 * A + 9;
+    uint32_t bLow = corner * corner >= x1 ? 0 : ceilSqrt(x1 - corner * corner) / 10;
+    uint32_t bHigh = min(uint32_t(A), isqrt(x2 - 100 * A * A) / 10);
+    heightShifts.push_back(bLow);
+    heights.push_back(bHigh >= bLow ? bHigh - bLow + 1 : 0);
+  }
+  sieveArray.assign(heights, UINT32_MAX); // all ones in binary representation
+  // Stamp out multiples of the pre-sieved primes not already left out of the
+  // donut, then put back the primes 3 and 3 + 2i themselves.
+  for (uint32_t u = 0; u < heights.size(); u++)
+  {
+    sieveArray.stamp(u, presieveDonutColumn(A0 + u), presieveDonutModulus, heightShifts[u]);
+  }
+  for (gint g : {gint(3, 0), gint(3, 2)})
+  {
+    if (inSieveArray(g))
+    {
+      setTrue(g.a, g.b);
+    }
+  }
+  if (inSieveArray(gint(1, 0)))
+  {
+    setFalse(1, 0); // 1 is not prime
+  }
+  if (verbose)
+  {
+    printSieveArrayInfo();
+  }
+}
+
+// Is the word holding g = a + bi, with a, b >= 0, in the sieve array.
+bool AnnulusDonutSieve::inSieveArray(gint g)
+{
+  uint32_t u = g.a / 10 - A0;
+  uint32_t B = g.b / 10;
+  return (uint32_t(g.a / 10) >= A0) && (u < sieveArray.size()) && (B >= heightShifts[u]) &&
+         (B - heightShifts[u] < sieveArray.columnSize(u));
+}
+
+void AnnulusDonutSieve::crossOffMultiples(gint g)
+{
+  // Multiples already left out of the donut or stamped out in setSieveArray().
+  if (isPresieved(g))
+  {
+    return;
+  }
+  uint64_t N = g.norm();
+  if (N > x2 / N)
+  {
+    return; // no composite in the annulus has g as its smallest prime factor
+  }
+  uint64_t lo = (x1 + N - 1) / N;
+  uint64_t hi = x2 / N;
+  uint64_t c = max(ceilSqrt((lo + 1) / 2), 1u); // ignoring c, d = 0, 0
+  uint64_t dLow = c * c >= lo ? 0 : ceilSqrt(lo - c * c);
+  uint64_t dTop = c * c <= hi ? isqrt(hi - c * c) : 0;
+  for (; c <= isqrt(hi); c++)
+  {
+    while ((dLow > 0) && (c * c + (dLow - 1) * (dLow - 1) >= lo))
+    {
+      dLow--;
+    }
+    while (c * c + dTop * dTop > hi)
+    {
+      dTop--;
+    }
+    // first d >= dLow with c + di in the donut
+    uint64_t d = dLow;
+    while (!donut.gap[c % 10][d % 10])
+    {
+      d++;
+    }
+    uint64_t dUpper = min(c, dTop);
+    int64_t u = int64_t(c) * g.a - int64_t(d) * g.b; // u = ac - bd
+    int64_t v = int64_t(c) * g.b + int64_t(d) * g.a; // v = bc + ad
+    while (d <= dUpper)
+    {
+      // Apply units and conjugate until u + vi is in the first octant; v >= 0.
+      int64_t r = u < 0 ? -u : u;
+      setFalse(uint32_t(max(r, v)), uint32_t(min(r, v)));
+      uint32_t jump = donut.gap[c % 10][d % 10];
+      d += jump;
+      u -= jump * g.b;
+      v += jump * g.a;
+    }
+  }
+  // Uncrossing the gint itself, crossed off when c = 1 and d = 0.
+  if ((x1 <= N) && (N <= x2))
+  {
+    gint h = g.a >= g.b ? g : g.flip();
+    setTrue(h.a, h.b);
+  }
+  if (verbose)
+  {
+    printProgress(g);
+  }
+}
+
+void AnnulusDonutSieve::setFalse(uint32_t u, uint32_t v)
+{
+  uint32_t w = u / 10 - A0;
+  sieveArray[w][v / 10 - heightShifts[w]] &= ~(1u << donut.bit[u % 10][v % 10]);
+}
+
+void AnnulusDonutSieve::setTrue(uint32_t u, uint32_t v)
+{
+  uint32_t w = u / 10 - A0;
+  sieveArray[w][v / 10 - heightShifts[w]] |= 1u << donut.bit[u % 10][v % 10];
+}
+
+void AnnulusDonutSieve::harvestBigPrimes(PrimeSink &sink)
+{
+  if (verbose)
+  {
+    cerr << "Gathering primes after sieve..." << endl;
+  }
+  // Putting in primes dividing 10.
+  if ((x1 <= 2) && (2 <= x2))
+  {
+    sink.push(gint(1, 1));
+  }
+  if ((x1 <= 5) && (5 <= x2))
+  {
+    sink.push(gint(2, 1));
+    sink.push(gint(1, 2));
+  }
+  for (uint32_t u = 0; u < sieveArray.size(); u++)
+  {
+    for (uint32_t B = 0; B < sieveArray.columnSize(u); B++)
+    {
+      for (uint32_t word = sieveArray[u][B]; word; word &= word - 1)
+      {
+        uint32_t bit = __builtin_ctz(word);
+        gint g(10 * (A0 + u) + donut.realPart[bit], 10 * (B + heightShifts[u]) + donut.imagPart[bit]);
+        // check for words sticking out of the annulus or over the diagonal
+        if ((g.a > g.b) && (x1 <= g.norm()) && (g.norm() <= x2))
+        {
+          sink.push(g);
+          if (g.b)
+          { // prime not on real axis
+            sink.push(g.flip());
+          }
+        }
+      }
+    }
+  }
+  if (verbose)
+  {
+    cerr << "Done gathering." << endl;
+  }
+}
+
+uint64_t AnnulusDonutSieve::getCountBigPrimes()
+{
+  if (verbose)
+  {
+    cerr << "Counting primes after sieve..." << endl;
+  }
+  uint64_t count = 0;
+  count += (x1 <= 2) && (2 <= x2);     // 1 + i
+  count += 2 * ((x1 <= 5) && (5 <= x2)); // 2 + i and 1 + 2i
+  for (uint32_t u = 0; u < sieveArray.size(); u++)
+  {
+    const uint32_t *column = sieveArray[u];
+    for (uint32_t B = 0; B < sieveArray.columnSize(u); B++)
+    {
+      for (uint32_t word = column[B]; word; word &= word - 1)
+      {
+        uint32_t bit = __builtin_ctz(word);
+        uint64_t a = 10 * (A0 + u) + donut.realPart[bit];
+        uint64_t b = 10 * (B + heightShifts[u]) + donut.imagPart[bit];
+        if ((a > b) && (x1 <= a * a + b * b) && (a * a + b * b <= x2))
+        {
+          count += b ? 2 : 1; // primes not on the real axis are counted twice
+        }
+      }
+    }
+  }
+  count *= 4; // four quadrants
+  if (verbose)
+  {
+    cerr << "Total number of primes, including associates: " << count << "\n"
+         << endl;
+  }
+  return count;
+}
@@ -0,0 +1,328 @@
+/* Perform sieving in the annulus of the first octant defined by x1 <= norm <= x2.
+ * Must have x1 <= x2. As in OctantSieve, multiples of a small prime g are
+ * found through cofactors c + di in the first octant and brought back into the
+ * octant with units and conjugation; here only cofactors of norm between
+ * x1 / N(g) and x2 / N(g) are visited.
+ *
+ * With an angular window alpha <= arg < beta in [0, pi/2], the annulus is cut
+ * down to an annular sector of the first quadrant. As in SectorSieve, the
+ * cofactors of g = a + bi then run over the annular sector rotated by -arg(g),
+ * so that only a thin slice of the cofactor plane is visited when the window
+ * is narrow. Since the cofactor lines cross the sector at an angle, their
+ * bounds are only computed up to a margin, and every multiple is checked
+ * against the columns of the sieve array before it is crossed off.
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <cmath>
+#include "AnnulusSieve.hpp"
+#include "SmallPrimes.hpp"
+#include "Presieve.hpp"
+using namespace std;
+
+// Using an initializer list in the constructor.
+AnnulusSieve::AnnulusSieve(uint64_t x1, uint64_t x2, bool verbose)
+    : SieveTemplate<bool>(x2, verbose), x1(x1), x2(x2), windowed(false), alpha(0), beta(M_PI_4),
+      alphaRay(0.0L), betaRay(M_PI_4), aMin(0)
+{
+  if (x1 > x2)
+  {
+    throw invalid_argument("The inner norm x1 should not exceed the outer norm x2.");
+  }
+}
+
+AnnulusSieve::AnnulusSieve(uint64_t x1, uint64_t x2, long double alpha, long double beta, bool verbose)
+    : SieveTemplate<bool>(x2, verbose), x1(x1), x2(x2), windowed(true),
+      alpha(min(alpha, beta)), beta(max(alpha, beta)),
+      alphaRay(min(alpha, beta)), betaRay(max(alpha, beta)), aMin(0)
+{
+  if (x1 > x2)
+  {
+    throw invalid_argument("The inner norm x1 should not exceed the outer norm x2.");
+  }
+  if ((this->beta > M_PI_2) || (this->alpha < 0) || (this->alpha == this->beta))
+  {
+    throw invalid_argument("The interval [alpha, beta) should be a nonempty subinterval of [0, pi/2].");
+  }
+}
+
+void AnnulusSieve::setSmallPrimes()
+{
+  if (verbose)
+  {
+    cerr << "Taking smallPrimes from the shared table..." << endl;
+  }
+  smallPrimes = SmallPrimes::upTo(isqrt(x2)).toVector();
+}
+
+// The sieve array holds the gints a + bi with b <= a and x1 <= a^2 + b^2 <= x2.
+// The leftmost column meets the annulus on the diagonal, where 2a^2 >= x1. With
+// a window, column a instead runs from the ray alpha or the inner circle up to
+// the ray beta or the outer circle; the leftmost column meets the inner circle
+// on the ray beta, and the rightmost meets the outer circle on the ray alpha.
+void AnnulusSieve::setSieveArray()
+{
+  if (verbose)
+  {
+    cerr << "Building sieve array..." << endl;
+  }
+  uint32_t aMax = isqrt(x2);
+  if (windowed)
+  {
+    aMin = max(int64_t(sqrtl(x1) * cosl(beta)) - 1, int64_t(0));
+    aMax = min(aMax, uint32_t(sqrtl(x2) * cosl(alpha)) + 1);
+  }
+  else
+  {
+    aMin = ceilSqrt((x1 + 1) / 2);
+  }
+  heightShifts.clear();
+  vector<uint32_t> heights;
+  for (uint64_t a = aMin; a <= aMax; a++)
+  {
+    uint32_t bLow = a * a >= x1 ? 0 : ceilSqrt(x1 - a * a);
+    int64_t bHigh = isqrt(x2 - a * a);
+    if (!windowed)
+    {
+      bHigh = min(bHigh, int64_t(a));
+    }
+    else
+    { // keeping alpha <= arg(a + bi) < beta, as in SectorSieve
+      bHigh = int64_t(min(int128_t(bHigh), betaRay.lowestAbove(a) - 1));
+      bLow = uint32_t(min(max(int128_t(bLow), alphaRay.lowestAbove(a)), int128_t(bHigh) + 1));
+    }
+    heightShifts.push_back(bLow);
+    heights.push_back(bHigh >= bLow ? bHigh - bLow + 1 : 0);
+  }
+  sieveArray.assign(heights, true);
+  for (uint32_t u = 0; u < heights.size(); u++)
+  {
+    sieveArray.stamp(u, presieveColumn(aMin + u), presieveWords, heightShifts[u]);
+  }
+  // The pre-sieved primes themselves were crossed off with their multiples.
+  for (gint g : {gint(1, 1), gint(2, 1), gint(1, 2), gint(3, 0), gint(3, 2), gint(2, 3)})
+  {
+    if (inSieveArray(g))
+    {
+      sieveArray.set(g.a - aMin, g.b - heightShifts[g.a - aMin]);
+    }
+  }
+  if (inSieveArray(gint(1, 0)))
+  {
+    sieveArray.reset(1 - aMin, 0); // 1 is not prime
+  }
+  if (verbose)
+  {
+    printSieveArrayInfo();
+  }
+}
+
+// Is g = a + bi, with a, b >= 0, held in the sieve array.
+bool AnnulusSieve::inSieveArray(gint g)
+{
+  uint32_t u = g.a - aMin;
+  return (uint32_t(g.a) >= aMin) && (u < sieveArray.size()) &&
+         (uint32_t(g.b) >= heightShifts[u]) && (g.b - heightShifts[u] < sieveArray.columnSize(u));
+}
+
+// Let c + di be the cofactor of a multiple of g = a + bi. Then c + di runs over
+// the first octant with x1 / N(g) <= c^2 + d^2 <= x2 / N(g). For each c, the
+// bounds on d only decrease as c grows, so they are updated incrementally.
+void AnnulusSieve::crossOffMultiples(gint g)
+{
+  // Multiples already crossed off in setSieveArray().
+  if (isPresieved(g))
+  {
+    return;
+  }
+  uint64_t N = g.norm();
+  if (N > x2 / N)
+  {
+    return; // no composite in the annulus has g as its smallest prime factor
+  }
+  if (windowed)
+  {
+    crossOffWindowMultiples(g);
+    return;
+  }
+  uint64_t lo = (x1 + N - 1) / N;
+  uint64_t hi = x2 / N;
+  uint64_t c = max(ceilSqrt((lo + 1) / 2), 1u); // ignoring c, d = 0, 0
+  uint64_t dLow = c * c >= lo ? 0 : ceilSqrt(lo - c * c);
+  uint64_t dTop = c * c <= hi ? isqrt(hi - c * c) : 0;
+  for (; c <= isqrt(hi); c++)
+  {
+    while ((dLow > 0) && (c * c + (dLow - 1) * (dLow - 1) >= lo))
+    {
+      dLow--;
+    }
+    while (c * c + dTop * dTop > hi)
+    {
+      dTop--;
+    }
+    uint64_t d = dLow;
+    uint64_t dUpper = min(c, dTop);
+    int64_t u = int64_t(c) * g.a - int64_t(d) * g.b; // u = ac - bd
+    int64_t v = int64_t(c) * g.b + int64_t(d) * g.a; // v = bc + ad
+    for (; d <= dUpper; d++)
+    {
+      // Apply units and conjugate until u + vi is in the first octant; v >= 0.
+      int64_t r = u < 0 ? -u : u;
+      int64_t s = max(r, v);
+      int64_t t = min(r, v);
+      sieveArray.reset(s - aMin, t - heightShifts[s - aMin]);
+      u -= g.b;
+      v += g.a;
+    }
+  }
+  // Uncrossing the gint itself, crossed off when c = 1 and d = 0.
+  if ((x1 <= N) && (N <= x2))
+  {
+    gint h = g.a >= g.b ? g : g.flip();
+    sieveArray.set(h.a - aMin, h.b - heightShifts[h.a - aMin]);
+  }
+  if (verbose)
+  {
+    printProgress(g);
+  }
+}
+
+// Cross off the multiples (a + bi)(c + di) with d0 <= d <= d1 that lie in the
+// sieve array.
+void AnnulusSieve::crossOffLine(gint g, int64_t c, int64_t d0, int64_t d1)
+{
+  int64_t u = c * g.a - d0 * g.b; // u = ac - bd
+  int64_t v = c * g.b + d0 * g.a; // v = bc + ad
+  for (int64_t d = d0; d <= d1; d++)
+  {
+    int64_t w = u - aMin;
+    if ((w >= 0) && (w < int64_t(sieveArray.size())) && (v >= heightShifts[w]) &&
+        (v - heightShifts[w] < sieveArray.columnSize(w)))
+    {
+      sieveArray.reset(w, v - heightShifts[w]);
+    }
+    u -= g.b;
+    v += g.a;
+  }
+}
+
+// Let c + di be the cofactor of a multiple of g = a + bi, and put phi = arg(c + di).
+// Then c + di runs over sqrt(lo) <= |c + di| <= sqrt(hi) and alpha - arg(g) <=
+// phi < beta - arg(g), an annular sector on which c > 0. The line of cofactors
+// with real part c meets it in d >= 0 and in d < 0, each an interval.
+void AnnulusSieve::crossOffWindowMultiples(gint g)
+{
+  uint64_t N = g.norm();
+  uint64_t lo = (x1 + N - 1) / N;
+  uint64_t hi = x2 / N;
+  long double r = sqrtl(N);
+  // sines and cosines of the angles alpha - arg(g) and beta - arg(g)
+  long double sinLow = (g.a * sinl(alpha) - g.b * cosl(alpha)) / r;
+  long double cosLow = (g.a * cosl(alpha) + g.b * sinl(alpha)) / r;
+  long double sinHigh = (g.a * sinl(beta) - g.b * cosl(beta)) / r;
+  long double cosHigh = (g.a * cosl(beta) + g.b * sinl(beta)) / r;
+  // The cofactor sector reaches furthest left on the inner circle and furthest
+  // right on the outer circle, on one of its rays unless it straddles phi = 0.
+  int64_t cMin = max(int64_t(sqrtl(lo) * min(cosLow, cosHigh)) - 1, int64_t(1));
+  long double cosMax = (sinLow <= 0) && (sinHigh >= 0) ? 1 : max(cosLow, cosHigh);
+  int64_t cMax = min(int64_t(sqrtl(hi) * cosMax) + 1, int64_t(sqrtl(hi)) + 1);
+  // Slopes of the rays; cosHigh is 0 only for beta = pi/2 and g real, when the
+  // upper ray is vertical. Doubles are plenty here, as a margin of one is left
+  // on either side of each ray.
+  double slopeLow = sinLow / cosLow;
+  double slopeHigh = cosHigh > 0 ? double(sinHigh / cosHigh) : HUGE_VAL;
+  for (int64_t c = cMin; (c <= cMax) && (uint64_t(c * c) <= hi); c++)
+  {
+    int64_t outer = floorSqrt(hi - c * c);
+    int64_t inner = uint64_t(c * c) >= lo ? 0 : floorSqrt(lo - c * c);
+    int64_t dLow = max(int64_t(floor(c * slopeLow)) - 1, -outer);
+    int64_t dHigh = c * slopeHigh < outer ? int64_t(floor(c * slopeHigh)) + 1 : outer;
+    crossOffLine(g, c, max(dLow, max(inner, int64_t(0))), dHigh); // d >= 0
+    crossOffLine(g, c, dLow, min(dHigh, -max(inner, int64_t(1))));  // d < 0
+  }
+  // Uncrossing the gint itself, crossed off when c = 1 and d = 0.
+  if (inSieveArray(g))
+  {
+    sieveArray.set(g.a - aMin, g.b - heightShifts[g.a - aMin]);
+  }
+  if (verbose)
+  {
+    printProgress(g);
+  }
+}
+
+// Each prime a + bi of the octant also gives its flip b + ai, except on the
+// real axis and on the diagonal, where the only prime is 1 + i. With a window,
+// the array already holds every prime of the annular sector.
+void AnnulusSieve::harvestBigPrimes(PrimeSink &sink)
+{
+  if (verbose)
+  {
+    cerr << "Gathering primes after sieve..." << endl;
+  }
+  for (uint32_t u = 0; u < sieveArray.size(); u++)
+  {
+    int32_t a = aMin + u;
+    sieveArray.forEach(u, 0, sieveArray.columnSize(u), [&](uint32_t v) {
+      gint g(a, v + heightShifts[u]);
+      sink.push(g);
+      if (!windowed && g.b && (g.b != g.a))
+      {
+        sink.push(g.flip());
+      }
+    });
+  }
+  if (verbose)
+  {
+    cerr << "Done gathering." << endl;
+  }
+}
+
+uint64_t AnnulusSieve::getCountBigPrimes()
+{
+  if (verbose)
+  {
+    cerr << "Counting primes after sieve..." << endl;
+  }
+  uint64_t count = 0;
+  for (uint32_t u = 0; u < sieveArray.size(); u++)
+  {
+    uint32_t height = sieveArray.columnSize(u);
+    if (!height)
+    {
+      continue;
+    }
+    if (windowed)
+    {
+      count += sieveArray.count(u, 0, height);
+      continue;
+    }
+    // Primes not on the real axis or the diagonal are counted twice.
+    count += 2 * sieveArray.count(u, 0, height);
+    if (heightShifts[u] == 0)
+    {
+      count -= sieveArray.test(u, 0);
+    }
+    if (heightShifts[u] + height - 1 == aMin + u)
+    {
+      count -= sieveArray.test(u, height - 1);
+    }
+  }
+  if (windowed)
+  {
+    if (verbose)
+    {
+      cerr << "Total number of primes in annular sector: " << count << "\n"
+           << endl;
+    }
+    return count;
+  }
+  count *= 4; // four quadrants
+  if (verbose)
+  {
+    cerr << "Total number of primes, including associates: " << count << "\n"
+         << endl;
+  }
+  return count;
+}
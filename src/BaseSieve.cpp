@@ -4,6 +4,8 @@
 #include <iomanip>
 #include <cmath>
 #include "BaseSieve.hpp"
+#include "NormSort.hpp"
+#include "SmallPrimes.hpp"
 
 // Will call this constructor from derived classes.
 SieveBase::SieveBase(uint64_t maxNorm, bool verbose)
@@ -58,91 +60,132 @@ void SieveBase::run()
   sieve();
 }
 
-vector<gint> SieveBase::getBigPrimes(bool sort)
+void SieveBase::setBigPrimes()
 {
-  setBigPrimes();
-  if (sort)
+  visitBigPrimes([&](const vector<gint> &primes) {
+    bigPrimes.insert(bigPrimes.end(), primes.begin(), primes.end());
+  });
+}
+
+// Gathered into a fresh vector so that nothing is copied on return.
+vector<gint> SieveBase::getBigPrimes(bool sort, bool radix)
+{
+  vector<gint> primes;
+  visitBigPrimes([&](const vector<gint> &chunk) {
+    primes.insert(primes.end(), chunk.begin(), chunk.end());
+  });
+  if (sort && radix)
   {
-    sortBigPrimes();
+    radixSortByNorm(primes);
   }
-  return bigPrimes;
+  else if (sort)
+  {
+    std::sort(primes.begin(), primes.end());
+  }
+  return primes;
 }
 
-void SieveBase::sortBigPrimes()
+void SieveBase::sortBigPrimes(bool radix)
 {
   if (verbose)
   {
     cerr << "Sorting primes by norm..." << endl;
   }
-  sort(bigPrimes.begin(), bigPrimes.end());
+  if (radix)
+  {
+    radixSortByNorm(bigPrimes);
+  }
+  else
+  {
+    sort(bigPrimes.begin(), bigPrimes.end());
+  }
   if (verbose)
   {
     cerr << "Done sorting." << endl;
   }
 }
 
-void SieveBase::printBigPrimes()
+// Write the big primes to each of the streams, one "a b" line per prime.
+// Sorting needs every prime at once, so they are gathered into bigPrimes first
+// (unless this has already been done); otherwise they are written out chunk by
+// chunk as the sieve finds them. Every stream is written in the same pass, as
+// some sieves only sieve while their primes are harvested.
+static uint64_t writeBigPrimes(SieveBase &s, vector<gint> &bigPrimes, bool sort, const vector<ostream *> &outs)
 {
-  for (gint g : bigPrimes)
+  uint64_t count = 0;
+  auto write = [&](const vector<gint> &primes) {
+    for (ostream *out : outs)
+    {
+      for (gint g : primes)
+      {
+        *out << g.a << ' ' << g.b << '\n';
+      }
+    }
+    count += primes.size();
+  };
+  if (!sort)
+  {
+    s.visitBigPrimes(write);
+    return count;
+  }
+  if (bigPrimes.empty())
   {
-    cout << g.a << " " << g.b << endl;
+    s.setBigPrimes();
+    s.sortBigPrimes(true);
   }
-  cerr << "Total number of primes printed: " << bigPrimes.size() << endl;
+  write(bigPrimes);
+  return count;
 }
 
-void SieveBase::writeBigPrimesToFile()
+void SieveBase::outputBigPrimes(bool sort, bool print, bool toFile)
 {
+  vector<ostream *> outs;
   ofstream f;
-  f.open("cpp_primes.csv");
-  for (gint g : bigPrimes)
+  if (toFile)
   {
-    f << g.a << ' ' << g.b << endl;
+    f.open("cpp_primes.csv");
+    outs.push_back(&f);
   }
-  f.close();
-}
-
-// Getting all primes from file small_primes.txt with norm up to maxNorm variable.
-// Old method; keeping as a reference.
-void SieveBase::setSmallPrimesFromFile()
-{
-  // If maxNorm is too small, then we are not actually taking any primes.
-  if (maxNorm < 2)
+  if (print)
   {
-    cerr << "No primes read and no sieving needed.";
-    exit(1);
+    outs.push_back(&cout);
   }
-  // small_primes.txt contains a list of Gaussian primes sorted by norm.
-  ifstream f;
-  f.open("PUT IN PATH TO FILE");
-  if (!f)
+  if (outs.empty())
   {
-    cerr << "Unable to open file.";
-    exit(1);
+    return;
   }
-  else
+  uint64_t count = writeBigPrimes(*this, bigPrimes, sort, outs);
+  if (toFile)
+  {
+    f.close();
+  }
+  if (print)
   {
-    cerr << "Reading small primes from file." << endl;
+    cout.flush();
+    cerr << "Total number of primes printed: " << count << endl;
   }
+}
+
+void SieveBase::printBigPrimes(bool sort)
+{
+  outputBigPrimes(sort, true, false);
+}
+
+void SieveBase::writeBigPrimesToFile(bool sort)
+{
+  outputBigPrimes(sort, false, true);
+}
 
-  int32_t a, b;
-  f >> a >> b; // token-based parsing
-  gint g(a, b);
-  // Need primes up to square root of the maxNorm
-  while (g.norm() <= isqrt(maxNorm))
+// Taking small primes from the cache file at path for this sieve only. The file
+// is mapped when it already reaches isqrt(maxNorm), and otherwise written from
+// the shared table; the cache file of every other sieve stays as it was.
+void SieveBase::setSmallPrimesFromFile(const string &path)
+{
+  if (verbose)
   {
-    smallPrimes.push_back(g);
-    f >> a >> b; // reading next pair a, b from file f
-    g = gint(a, b);
-    // If we get to the end of the file, then we don't have enough precomputed primes.
-    if (f.eof())
-    {
-      cerr << "Not enough primes in PATH TO FILE" << endl;
-      cerr << "Need to override this method with a sieve instance." << endl;
-      f.close();
-      exit(1);
-    }
+    cerr << "Taking smallPrimes from the cache file " << path << "..." << endl;
   }
-  f.close();
+  smallPrimes = SmallPrimes::fromFile(path, isqrt(maxNorm)).toVector();
 }
 
 void SieveBase::setSmallPrimesFromReference(const vector<gint> &v)
@@ -155,13 +198,8 @@ void SieveBase::setSmallPrimesFromReference(const vector<gint> &v)
 template <>
 void SieveTemplate<bool>::printSieveArrayInfo()
 {
-  uint64_t totalSize = sizeof(sieveArray);
-  uint64_t nEntries = 0;
-  for (const auto &column : sieveArray)
-  {
-    totalSize += sizeof(column) + column.capacity() / 8; // each bool stored as a bit
-    nEntries += column.size();
-  }
+  uint64_t totalSize = sizeof(sieveArray) + sieveArray.memoryUse(); // each bool stored as a bit
+  uint64_t nEntries = sieveArray.nEntries();
   totalSize /= pow(10, 6); // convert to MB
   cerr << "Sieve array approximate memory use: " << totalSize << "MB." << endl;
   cerr << "Sieve array total number of entries: " << nEntries << endl;
@@ -170,13 +208,18 @@ void SieveTemplate<bool>::printSieveArrayInfo()
 template <>
 void SieveTemplate<uint32_t>::printSieveArrayInfo()
 {
-  uint64_t totalSize = sizeof(sieveArray);
-  uint64_t nEntries = 0;
-  for (const auto &column : sieveArray)
-  {
-    totalSize += sizeof(column) + column.capacity() * sizeof(uint32_t);
-    nEntries += column.size() * 32;
-  }
+  uint64_t totalSize = sizeof(sieveArray) + sieveArray.memoryUse();
+  uint64_t nEntries = sieveArray.nEntries() * 32;
+  totalSize /= pow(10, 6); // convert to MB
+  cerr << "Sieve array approximate memory use: " << totalSize << "MB." << endl;
+  cerr << "Sieve array total number of entries: " << nEntries << endl;
+}
+
+template <>
+void SieveTemplate<uint64_t>::printSieveArrayInfo()
+{
+  uint64_t totalSize = sizeof(sieveArray) + sieveArray.memoryUse();
+  uint64_t nEntries = sieveArray.nEntries() * 64;
   totalSize /= pow(10, 6); // convert to MB
   cerr << "Sieve array approximate memory use: " << totalSize << "MB." << endl;
   cerr << "Sieve array total number of entries: " << nEntries << endl;
@@ -187,22 +230,22 @@ void SieveTemplate<bool>::printSieveArray()
 {
   // Print sieve array with same orientation as that in the complex plane.
   uint32_t columnMaxSize = 0;
-  for (auto &column : sieveArray)
+  for (uint32_t u = 0; u < sieveArray.size(); u++)
   {
-    if (column.size() > columnMaxSize)
+    if (sieveArray.columnSize(u) > columnMaxSize)
     {
-      columnMaxSize = column.size();
+      columnMaxSize = sieveArray.columnSize(u);
     }
   }
   // Some type casting because subtraction confuses it.
   for (auto v = (int32_t)columnMaxSize - 1; v >= 0; v--)
   {
     string row;
-    for (auto &column : sieveArray)
+    for (uint32_t u = 0; u < sieveArray.size(); u++)
     {
-      if (int32_t(column.size()) > v)
+      if (int32_t(sieveArray.columnSize(u)) > v)
       {
-        if (column[v])
+        if (sieveArray.test(u, v))
         {
           row += '*'; // found a prime
         }
@@ -225,20 +268,20 @@ void SieveTemplate<uint32_t>::printSieveArray()
 {
   // Print sieve array with same orientation as that in the complex plane.
   uint32_t columnMaxSize = 0;
-  for (auto &column : sieveArray)
+  for (uint32_t u = 0; u < sieveArray.size(); u++)
   {
-    if (column.size() > columnMaxSize)
+    if (sieveArray.columnSize(u) > columnMaxSize)
     {
-      columnMaxSize = column.size();
+      columnMaxSize = sieveArray.columnSize(u);
     }
   }
   // Some type casting because subtraction confuses it.
   for (auto v = (int32_t)columnMaxSize - 1; v >= 0; v--)
   {
     string row;
-    for (auto &column : sieveArray)
+    for (uint32_t u = 0; u < sieveArray.size(); u++)
     {
-      if (int32_t(column.size()) > v)
+      if (int32_t(sieveArray.columnSize(u)) > v)
       {
         // printing entire block padded by 1
         // could use binary or hex or ints ...
@@ -246,7 +289,7 @@ void SieveTemplate<uint32_t>::printSieveArray()
         // row += b.to_string('-', '*');
         // row += ' ';
         stringstream stream;
-        stream << setfill('0') << setw(8) << hex << column[v];
+        stream << setfill('0') << setw(8) << hex << sieveArray[u][v];
         string result(stream.str());
         row += result;
         row += ' ';
@@ -260,28 +303,75 @@ void SieveTemplate<uint32_t>::printSieveArray()
   }
 }
 
+template <>
+void SieveTemplate<uint64_t>::printSieveArray()
+{
+  // Print sieve array with same orientation as that in the complex plane.
+  uint32_t columnMaxSize = 0;
+  for (uint32_t u = 0; u < sieveArray.size(); u++)
+  {
+    if (sieveArray.columnSize(u) > columnMaxSize)
+    {
+      columnMaxSize = sieveArray.columnSize(u);
+    }
+  }
+  // Some type casting because subtraction confuses it.
+  for (auto v = (int32_t)columnMaxSize - 1; v >= 0; v--)
+  {
+    string row;
+    for (uint32_t u = 0; u < sieveArray.size(); u++)
+    {
+      if (int32_t(sieveArray.columnSize(u)) > v)
+      {
+        stringstream stream;
+        stream << setfill('0') << setw(16) << hex << sieveArray[u][v];
+        string result(stream.str());
+        row += result;
+        row += ' ';
+      }
+      else
+      { // [u][v] index not in sieveArray
+        row += string(17, ' ');
+      }
+    }
+    cerr << row << endl;
+  }
+}
+
 template <>
 bool SieveTemplate<bool>::getSieveArrayValue(uint32_t u, uint32_t v)
 {
-  return sieveArray.at(u).at(v);
+  return sieveArray.at(u, v);
 }
 
 template <>
 uint32_t SieveTemplate<uint32_t>::getSieveArrayValue(uint32_t u, uint32_t v)
 {
-  return sieveArray.at(u).at(v);
+  return sieveArray.at(u, v);
+}
+
+template <>
+uint64_t SieveTemplate<uint64_t>::getSieveArrayValue(uint32_t u, uint32_t v)
+{
+  return sieveArray.at(u, v);
 }
 
 template <>
 vector<vector<bool>> SieveTemplate<bool>::getSieveArray()
 {
-  return sieveArray;
+  return sieveArray.toVectors();
 }
 
 template <>
 vector<vector<uint32_t>> SieveTemplate<uint32_t>::getSieveArray()
 {
-  return sieveArray;
+  return sieveArray.toVectors();
+}
+
+template <>
+vector<vector<uint64_t>> SieveTemplate<uint64_t>::getSieveArray()
+{
+  return sieveArray.toVectors();
 }
 
 // Other useful general purpose functions.
@@ -300,6 +390,29 @@ uint32_t isqrt(uint64_t n)
   return (uint32_t)x;
 }
 
+// Largest r with r * r <= n, from a floating point square root. This is
+// quicker than isqrt where a root is taken for every column of a sieve.
+uint32_t floorSqrt(uint64_t n)
+{
+  uint64_t r = min(sqrt(double(n)), double(UINT32_MAX));
+  while (r * r > n)
+  {
+    r--;
+  }
+  while ((r < UINT32_MAX) && ((r + 1) * (r + 1) <= n))
+  {
+    r++;
+  }
+  return uint32_t(r);
+}
+
+// Smallest r with r * r >= n.
+uint32_t ceilSqrt(uint64_t n)
+{
+  uint32_t r = floorSqrt(n);
+  return uint64_t(r) * r < n ? r + 1 : r;
+}
+
 // Positive remainder.
 uint32_t mod(int64_t k, uint32_t m)
 {
@@ -309,4 +422,33 @@ uint32_t mod(int64_t k, uint32_t m)
     r += m;
   }
   return uint32_t(r);
+}
+
+// Floor of k / m for m > 0, rounding toward negative infinity when k < 0.
+int64_t floorDiv(int64_t k, int64_t m)
+{
+  return k >= 0 ? k / m : -((m - 1 - k) / m);
+}
+
+// Annuli x1 + k (x2 - x1) / n have equal area. Two per thread keep the
+// workers busy to the end, while every extra annulus walks the lines of
+// cofactors of each small prime once more; the width is bounded so that the
+// sieve array of one annulus stays of bounded size.
+vector<pair<uint64_t, uint64_t>> equalAreaAnnuli(uint64_t x1, uint64_t x2, uint32_t threads)
+{
+  const uint64_t maxWidth = uint64_t(1) << 32;
+  uint64_t n = max(uint64_t(2) * threads, (x2 - x1) / maxWidth + 1);
+  n = min(n, x2 - x1 + 1);
+  vector<pair<uint64_t, uint64_t>> annuli;
+  uint64_t lower = x1;
+  for (uint64_t k = 1; k <= n; k++)
+  {
+    uint64_t upper = k == n ? x2 : x1 + uint64_t((long double)(x2 - x1) * k / n);
+    if (upper >= lower)
+    {
+      annuli.emplace_back(lower, upper);
+      lower = upper + 1;
+    }
+  }
+  return annuli;
 }
\ No newline at end of file
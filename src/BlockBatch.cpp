@@ -0,0 +1,105 @@
+/* Sieve a batch of blocks on a pool of threads. Every block needs the small
+ * primes up to the square root of its own largest norm. Here a single view of
+ * the shared table reaches the largest of these bounds, and each block stops
+ * at its own bound in this list of small primes sorted by norm.
+ *
+ * Blocks are handed out from a shared counter, so a thread which finishes
+ * early takes the next block rather than waiting on the others. Each thread
+ * holds the sieve array of a single block at a time, and results are written
+ * into the slot of their block, so the order of the batch is kept.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include "BlockBatch.hpp"
+#include "Threads.hpp"
+using namespace std;
+
+BlockBatch::BlockBatch(const vector<array<uint32_t, 4>> &blocks, bool verbose, uint32_t threads)
+    : blocks(blocks),
+      verbose(verbose),
+      threads(threadCount(threads)),
+      smallPrimes(SmallPrimes::upTo(0))
+{
+}
+
+// Largest norm in the block [x, x + dx) x [y, y + dy).
+static uint64_t blockMaxNorm(const array<uint32_t, 4> &block)
+{
+  uint64_t a = uint64_t(block[0]) + block[2] - 1;
+  uint64_t b = uint64_t(block[1]) + block[3] - 1;
+  return a * a + b * b;
+}
+
+void BlockBatch::setSmallPrimes()
+{
+  uint64_t maxNorm = 0;
+  for (const array<uint32_t, 4> &block : blocks)
+  {
+    maxNorm = max(maxNorm, blockMaxNorm(block));
+  }
+  if (verbose)
+  {
+    cerr << "Taking smallPrimes from the shared table for "
+         << blocks.size() << " block(s)..." << endl;
+  }
+  smallPrimes = SmallPrimes::upTo(isqrt(maxNorm));
+}
+
+// Sieve every block on the pool and pass it, with its index, to f. The calls
+// to f come from several threads, each with a different index.
+template <typename F>
+void BlockBatch::sieveBlocks(F f)
+{
+  if (blocks.empty())
+  {
+    return;
+  }
+  if (smallPrimes.empty())
+  {
+    setSmallPrimes();
+  }
+  if (verbose)
+  {
+    cerr << "Sieving " << blocks.size() << " block(s) with " << threads
+         << " thread(s)..." << endl;
+  }
+  forEachOnThreads(threads, blocks.size(), [&](uint64_t k, uint32_t) {
+    const array<uint32_t, 4> &block = blocks[k];
+    BlockSieve s(block[0], block[1], block[2], block[3], false);
+    s.setSieveArray();
+    uint32_t bound = isqrt(blockMaxNorm(block));
+    for (gint g : smallPrimes)
+    {
+      if (g.norm() > bound)
+      {
+        break;
+      }
+      s.crossOffMultiples(g);
+    }
+    f(k, s);
+  });
+  if (verbose)
+  {
+    cerr << "Sieving completed.\n"
+         << endl;
+  }
+}
+
+vector<uint64_t> BlockBatch::getCounts()
+{
+  vector<uint64_t> counts(blocks.size(), 0);
+  sieveBlocks([&](uint64_t k, BlockSieve &s) {
+    counts[k] = s.getCountBigPrimes();
+  });
+  return counts;
+}
+
+vector<vector<gint>> BlockBatch::getBigPrimes(bool sort, bool radix)
+{
+  vector<vector<gint>> primes(blocks.size());
+  sieveBlocks([&](uint64_t k, BlockSieve &s) {
+    primes[k] = s.getBigPrimes(sort, radix);
+  });
+  return primes;
+}
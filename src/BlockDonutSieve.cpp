@@ -5,10 +5,16 @@
 
 #include <iostream>
 #include <cmath>
-#include "OctantDonutSieve.hpp"
+#include <chrono>
 #include "BlockDonutSieve.hpp"
+#include "SmallPrimes.hpp"
+#include "BlockLines.hpp"
+#include "Presieve.hpp"
 using namespace std;
 
+constexpr Donut<10> BlockDonutSieve::donut;
+const uint32_t bandWords = 1 << 16; // 256 KB of the sieveArray in each band
+
 // Using an initializer list
 BlockDonutSieve::BlockDonutSieve(uint32_t x, uint32_t y, uint32_t dx, uint32_t dy, bool verbose)
     : SieveTemplate<uint32_t>(pow((uint64_t)(x + dx - 1), 2) + pow((uint64_t)(y + dy - 1), 2), verbose), x(x) // x-coordinate of lower left-hand corner of segment block
@@ -18,39 +24,6 @@ BlockDonutSieve::BlockDonutSieve(uint32_t x, uint32_t y, uint32_t dx, uint32_t d
       dx(dx) // horizontal side length of segment block
       ,
       dy(dy) // vertical side length of block
-
-      // For a fixed c, d will iterate by d += 2 or d += 4, similar to the classic
-      // wheel sieve. Got these iteration patterns in printDonut(), then pasted them
-      // here so they can be hard coded in constructor.
-
-      // donut array tracks how to move from one d to another during crossOffMultiples()
-      // note: rows and columns reversed from usual complex plane orientation -- don't get confused.
-      ,
-      gapDonut{{0, 2, 0, 4, 0, 0, 0, 2, 0, 2},
-               {4, 0, 0, 0, 2, 0, 4, 0, 0, 0},
-               {0, 0, 0, 2, 0, 2, 0, 6, 0, 0},
-               {2, 0, 6, 0, 0, 0, 0, 0, 2, 0},
-               {0, 4, 0, 0, 0, 4, 0, 0, 0, 2},
-               {0, 0, 2, 0, 2, 0, 2, 0, 4, 0},
-               {0, 4, 0, 0, 0, 4, 0, 0, 0, 2},
-               {2, 0, 6, 0, 0, 0, 0, 0, 2, 0},
-               {0, 0, 0, 2, 0, 2, 0, 6, 0, 0},
-               {4, 0, 0, 0, 2, 0, 4, 0, 0, 0}}
-
-      ,
-      bitDonut{{99, 0, 99, 1, 99, 99, 99, 2, 99, 3},
-               {4, 99, 99, 99, 5, 99, 6, 99, 99, 99},
-               {99, 99, 99, 7, 99, 8, 99, 9, 99, 99},
-               {10, 99, 11, 99, 99, 99, 99, 99, 12, 99},
-               {99, 13, 99, 99, 99, 14, 99, 99, 99, 15},
-               {99, 99, 16, 99, 17, 99, 18, 99, 19, 99},
-               {99, 20, 99, 99, 99, 21, 99, 99, 99, 22},
-               {23, 99, 24, 99, 99, 99, 99, 99, 25, 99},
-               {99, 99, 99, 26, 99, 27, 99, 28, 99, 99},
-               {29, 99, 99, 99, 30, 99, 31, 99, 99, 99}}
-
-      ,
-      realPartDecompress{0, 0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9}, imagPartDecompress{1, 3, 7, 9, 0, 4, 6, 3, 5, 7, 0, 2, 8, 1, 5, 9, 2, 4, 6, 8, 1, 5, 9, 0, 2, 8, 3, 5, 7, 0, 4, 6}
 {
   if ((x % 10) || (y % 10) || (dx % 10) || (dy % 10))
   {
@@ -64,11 +37,9 @@ void BlockDonutSieve::setSmallPrimes()
 {
   if (verbose)
   {
-    cerr << "Calling the OctantDonutSieve to generate smallPrimes..." << endl;
+    cerr << "Taking smallPrimes from the shared table..." << endl;
   }
-  OctantDonutSieve s((uint64_t)isqrt(maxNorm), false);
-  s.run();
-  smallPrimes = s.getBigPrimes();
+  smallPrimes = SmallPrimes::upTo(isqrt(maxNorm)).toVector();
 }
 
 // Sieve array holds indices corresponding to gints with x <= a < x + dx and
@@ -82,11 +53,8 @@ void BlockDonutSieve::setSieveArray()
   }
   // trick to take integer division ceiling instead of floor
   // each donut block must start at a multiple of 10
-  for (uint64_t i = 0; i < dx / 10; i++)
-  {
-    vector<uint32_t> column(dy / 10, (uint32_t)pow(2, 32) - 1);
-    sieveArray.push_back(column);
-  }
+  sieveArray.assign(dx / 10, dy / 10, UINT32_MAX); // all ones in binary representation
+  presieve();
   if ((x == 0) && (y == 0))
   {
     setFalse(1, 0); // Crossing off 1
@@ -98,91 +66,186 @@ void BlockDonutSieve::setSieveArray()
   }
 }
 
-// Cross off multiples of the gint g = a + bi within the sieveArray.
-// Let a + bi be the gint and c + di be the co-factor of the multiple we seek.
-// We must over integers c and d such that the product (a + bi)(c + di) is
-// contained in the segment block. This gives inequalities x <= ac - bd < x + dx
-// and y <= ad + bc < y + dy. Solve these for c to get
-// (ax + by) / (a^2 + b^2) <= c <= (a(x + dx - 1) + b(y + dy - 1)) / (a^2 + b^2).
-// Then d is defined by some max and min conditions.
-void BlockDonutSieve::crossOffMultiples(gint g)
+// Overwrite every word of the block with the donut words left by the pre-sieved
+// primes 3, 3 + 2i and 2 + 3i, then put back these primes if they are in the
+// block.
+void BlockDonutSieve::presieve()
 {
-  if (g.norm() <= 5)
-  {
-    return;
-  } // exit early if g is above 2 or 5.
-  // Convert everything to unsigned long type.
-  int64_t a = g.a;
-  int64_t b = g.b;
-  int64_t N = g.norm();
-  int64_t c, cUpper;
-  // Trick: to get ceiling of integer division n / m, call (n + m - 1) / m.
-  // This only works when both m and n > 0.
-  if (g.b)
-  {
-    c = (a * x + b * y + N - 1) / N; // using trick
-    cUpper = (a * (x + dx - 1) + b * (y + dy - 1)) / N;
-  }
-  else
+  for (uint32_t u = 0; u < dx / 10; u++)
   {
-    c = (x + a - 1) / a; // using trick
-    cUpper = (x + dx - 1) / a;
+    sieveArray.stamp(u, presieveDonutColumn(x / 10 + u), presieveDonutModulus, y / 10);
   }
-  for (; c <= cUpper; c++)
+  for (gint g : {gint(3, 0), gint(0, 3), gint(3, 2), gint(2, 3)})
   {
-    int64_t d, dUpper; // d isn't necessarily positive
-    if (b)
+    if ((int64_t(x) <= g.a) && (g.a < int64_t(x) + dx) && (int64_t(y) <= g.b) && (g.b < int64_t(y) + dy))
     {
-      // trick doesn't work because of sign; instead using ceil.
-      double d1 = double(a * c - x - dx + 1) / double(b);
-      double d2 = double(y - b * c) / double(a);
-      d = int64_t(ceil(max(d1, d2)));
-      // Reusing d1 and d2
-      d1 = double(a * c - x) / double(b);
-      d2 = double(y + dy - 1 - b * c) / double(a);
-      dUpper = int64_t(floor(min(d1, d2)));
+      setTrue(g.a - x, g.b - y);
     }
-    else
-    {
-      d = (y + a - 1) / a; // using trick
-      dUpper = (y + dy - 1) / a;
-    }
-    // Annoying indexing because d can be negative; need to use mod function
-    // defined in the BaseSieve.cpp file.
-    int32_t jump = gapDonut[c % 10][mod(d, 10)];
+  }
+}
+
+// Cross off multiples of the gint g = a + bi within the sieveArray. The lines
+// of multiples meeting the block are found by forEachLine().
+void BlockDonutSieve::crossOffMultiples(gint g)
+{
+  crossOffRows(g, 0, dy);
+}
+
+// Cross off multiples of g within the rows [v0, v1) of the sieveArray.
+void BlockDonutSieve::crossOffRows(gint g, uint32_t v0, uint32_t v1)
+{
+  if (isPresieved(g))
+  {
+    return;
+  } // exit early if g is above 2 or 5, or its multiples were stamped out
+  forEachLine(g, x, int64_t(y) + v0, dx, v1 - v0, [&](int64_t a, int64_t b, int64_t c, int64_t d, int64_t dUpper) {
+    // Residues of c and d mod 10 are kept by hand; both can be negative.
+    const uint8_t *gaps = donut.gap[mod(c, 10)];
+    uint32_t residue = mod(d, 10);
     // Now trying to figure out where to start d so that c + di is coprime to 10.
-    while (jump == 0)
+    while (gaps[residue] == 0)
     {
       d++;
-      jump = gapDonut[c % 10][mod(d, 10)];
+      residue = residue == 9 ? 0 : residue + 1;
     }
     int64_t u = a * c - b * d - x; // u = ac - bd - x
     int64_t v = b * c + a * d - y; // v = bc + ad - y
     while (d <= dUpper)
     {
       setFalse(u, v);
-      jump = gapDonut[c % 10][mod(d, 10)];
+      int32_t jump = gaps[residue];
+      residue = (residue + jump) % 10;
       d += jump;
       u -= jump * b;
       v += jump * a;
     }
-  }
-  if ((x <= a) && (a < x + dx) && (y <= b) && (b < y + dy))
+  });
+  restorePrime(g, v0, v1);
+}
+
+// Having crossed off the multiples of g within the rows [v0, v1), re-mark g
+// and its flip as prime if they lie in these rows.
+void BlockDonutSieve::restorePrime(gint g, uint32_t v0, uint32_t v1)
+{
+  int64_t y0 = int64_t(y) + v0;
+  int64_t y1 = int64_t(y) + v1;
+  if ((int64_t(x) <= g.a) && (g.a < int64_t(x) + dx) && (y0 <= g.b) && (g.b < y1))
   {
     // crossed this off; need to re-mark it as prime
-    setTrue(a - x, b - y);
+    setTrue(g.a - x, g.b - y);
   }
-  if ((x <= b) && (b < x + dx) && (y <= a) && (a < y + dy))
+  if ((int64_t(x) <= g.b) && (g.b < int64_t(x) + dx) && (y0 <= g.a) && (g.a < y1))
   {
     // crossed this off; need to re-mark it as prime
-    setTrue(b - x, a - y);
+    setTrue(g.b - x, g.a - y);
+  }
+}
+
+// Sieve the block a band of rows at a time, as in BlockSieve::sieve(); primes
+// of norm larger than dx^2 are bucket sieved.
+void BlockDonutSieve::sieve()
+{
+  uint32_t height = 10 * max(bandWords / (dx / 10), uint32_t(1));
+  if ((height < dx) || (height >= dy))
+  {
+    SieveBase::sieve(); // wide blocks, or a single band
+    return;
+  }
+  if (verbose)
+  {
+    cerr << "Starting to sieve in bands of " << height << " rows..." << endl;
+  }
+  auto startTime = chrono::high_resolution_clock::now();
+  // smallPrimes are sorted by norm; the large ones are left to the buckets.
+  uint32_t firstLarge = 0;
+  while ((firstLarge < smallPrimes.size()) && (smallPrimes[firstLarge].norm() <= uint64_t(dx) * dx))
+  {
+    firstLarge++;
+  }
+  vector<vector<BucketEntry>> buckets = fillBandBuckets(firstLarge, height);
+  for (uint32_t band = 0; band < buckets.size(); band++)
+  {
+    uint32_t v0 = band * height;
+    uint32_t v1 = min(uint64_t(v0) + height, uint64_t(dy));
+    for (uint32_t i = 0; i < firstLarge; i++)
+    {
+      crossOffRows(smallPrimes[i], v0, v1);
+    }
+    crossOffBandBucket(buckets, band, height);
+  }
+  for (uint32_t i = firstLarge; i < smallPrimes.size(); i++)
+  {
+    restorePrime(smallPrimes[i], 0, dy);
+  }
+  auto endTime = chrono::high_resolution_clock::now();
+  auto totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+  double printTime = double(totalTime.count()) / 1000.0;
+  if (verbose)
+  {
+    cerr << "\nDone sieving. Total time for sieving: " << printTime << " seconds." << endl;
   }
 }
 
+// File every line of multiples of the primes of smallPrimes from index
+// firstLarge on under the band of rows of the given height holding its lowest
+// multiple in the donut.
+vector<vector<BucketEntry>> BlockDonutSieve::fillBandBuckets(uint32_t firstLarge, uint32_t height)
+{
+  vector<vector<BucketEntry>> buckets((dy - 1) / height + 1);
+  for (uint32_t i = firstLarge; i < smallPrimes.size(); i++)
+  {
+    if (isPresieved(smallPrimes[i]))
+    {
+      continue; // primes above 2 and 5 have no multiples in the donut
+    }
+    forEachLine(smallPrimes[i], x, y, dx, dy, [&](int64_t a, int64_t b, int64_t c, int64_t d, int64_t dUpper) {
+      const uint8_t *gaps = donut.gap[mod(c, 10)];
+      while (gaps[mod(d, 10)] == 0)
+      {
+        d++;
+      }
+      if (d <= dUpper)
+      {
+        buckets[(b * c + a * d - y) / height].push_back({int32_t(a), int32_t(b), int32_t(c), int32_t(d)});
+      }
+    });
+  }
+  return buckets;
+}
+
+// Cross off the multiples of large primes within a band. Every line in the
+// bucket of the band is followed until it leaves the band, and is then refiled
+// under the next band it meets, unless it has left the block.
+void BlockDonutSieve::crossOffBandBucket(vector<vector<BucketEntry>> &buckets, uint32_t band, uint32_t height)
+{
+  int64_t top = min(uint64_t(band + 1) * height, uint64_t(dy));
+  for (BucketEntry e : buckets[band])
+  {
+    const uint8_t *gaps = donut.gap[mod(e.c, 10)];
+    uint32_t residue = mod(e.d, 10);
+    int64_t u = int64_t(e.a) * e.c - int64_t(e.b) * e.d - x; // u = ac - bd - x
+    int64_t v = int64_t(e.b) * e.c + int64_t(e.a) * e.d - y; // v = bc + ad - y
+    while ((v < top) && (u >= 0) && (u < dx))
+    {
+      setFalse(u, v);
+      int32_t jump = gaps[residue];
+      residue = (residue + jump) % 10;
+      e.d += jump;
+      u -= int64_t(jump) * e.b;
+      v += int64_t(jump) * e.a;
+    }
+    if ((v < dy) && (u >= 0) && (u < dx))
+    {
+      buckets[v / height].push_back(e);
+    }
+  }
+  vector<BucketEntry>().swap(buckets[band]); // done with this band
+}
+
 // Set the bit in the sieveArray to false corresponding to the gint u + vi
 void BlockDonutSieve::setFalse(uint32_t u, uint32_t v)
 {
-  uint32_t bit = bitDonut[u % 10][v % 10];
+  uint32_t bit = donut.bit[u % 10][v % 10];
   // clearing the bit; 1u is unsigned int
   sieveArray[u / 10][v / 10] &= ~(1u << bit);
 }
@@ -190,13 +253,13 @@ void BlockDonutSieve::setFalse(uint32_t u, uint32_t v)
 // Set the bit in the sieveArray to true corresponding to the gint u + vi
 void BlockDonutSieve::setTrue(uint32_t u, uint32_t v)
 {
-  unsigned char bit = bitDonut[u % 10][v % 10];
+  uint32_t bit = donut.bit[u % 10][v % 10];
   // setting the bit to 1; 1u is unsigned int
   sieveArray[u / 10][v / 10] |= (1u << bit);
 }
 
 // Combing through the sieve array to find primes after sieving.
-void BlockDonutSieve::setBigPrimes()
+void BlockDonutSieve::harvestBigPrimes(PrimeSink &sink)
 {
   if (verbose)
   {
@@ -205,23 +268,21 @@ void BlockDonutSieve::setBigPrimes()
   // Putting in primes dividing 10.
   if ((x < 10) && (y < 10))
   {
-    bigPrimes.emplace_back(1, 1);
-    bigPrimes.emplace_back(2, 1);
-    bigPrimes.emplace_back(1, 2);
+    sink.push(gint(1, 1));
+    sink.push(gint(2, 1));
+    sink.push(gint(1, 2));
   }
 
   for (uint32_t a = 0; a < dx / 10; a++)
   {
     for (uint32_t b = 0; b < dy / 10; b++)
     {
-      for (unsigned char bit = 0; bit < 32; bit++)
+      // Jump from one set bit to the next with ctz.
+      for (uint32_t word = sieveArray[a][b]; word; word &= word - 1)
       {
-        if ((sieveArray[a][b] >> bit) & 1u)
-        {
-          gint g(x + 10 * a + realPartDecompress[bit],
-                 y + 10 * b + imagPartDecompress[bit]);
-          bigPrimes.push_back(g);
-        }
+        uint32_t bit = __builtin_ctz(word);
+        sink.push(gint(x + 10 * a + donut.realPart[bit],
+                       y + 10 * b + donut.imagPart[bit]));
       }
     }
   }
@@ -247,13 +308,7 @@ uint64_t BlockDonutSieve::getCountBigPrimes()
   {
     for (uint32_t b = 0; b < dy / 10; b++)
     {
-      for (unsigned char bit = 0; bit < 32; bit++)
-      {
-        if ((sieveArray[a][b] >> bit) & 1u)
-        {
-          count++;
-        }
-      }
+      count += __builtin_popcount(sieveArray[a][b]);
     }
   }
   if (verbose)
@@ -5,10 +5,15 @@
 
 #include <iostream>
 #include <cmath>
+#include <chrono>
 #include "BlockSieve.hpp"
-#include "OctantSieve.hpp"
+#include "BlockLines.hpp"
+#include "SmallPrimes.hpp"
+#include "Presieve.hpp"
 using namespace std;
 
+const uint32_t bandBits = 1 << 21; // 256 KB of the sieveArray in each band
+
 // Using an initializer list in the constructor.
 BlockSieve::BlockSieve(
     uint32_t x,
@@ -30,16 +35,14 @@ BlockSieve::BlockSieve(
 {
 }
 
-// Method from SieveBase doesn't give enough primes, so calling the trusty octant sieve.
+// Method from SieveBase doesn't give enough primes, so taking them from the shared table.
 void BlockSieve::setSmallPrimes()
 {
   if (verbose)
   {
-    cerr << "Calling the OctantSieve to generate smallPrimes..." << endl;
+    cerr << "Taking smallPrimes from the shared table..." << endl;
   }
-  OctantSieve s((uint64_t)isqrt(maxNorm), false);
-  s.run();
-  smallPrimes = s.getBigPrimes();
+  smallPrimes = SmallPrimes::upTo(isqrt(maxNorm)).toVector();
 }
 
 // Sieve array holds indices corresponding to gints with x <= a < x + dx and
@@ -50,18 +53,27 @@ void BlockSieve::setSieveArray()
   {
     cerr << "Building sieve array..." << endl;
   }
-  for (uint32_t i = 0; i < dx; i++)
+  // Multiples of the pre-sieved primes are stamped in column by column.
+  sieveArray.assign(dx, dy, true);
+  for (uint32_t u = 0; u < dx; u++)
   {
-    vector<bool> column(dy, true);
-    sieveArray.push_back(column);
+    sieveArray.stamp(u, presieveColumn(x + u), presieveWords, y);
+  }
+  // The pre-sieved primes themselves were crossed off with their multiples.
+  for (gint g : {gint(1, 1), gint(2, 1), gint(1, 2), gint(3, 0), gint(0, 3), gint(3, 2), gint(2, 3)})
+  {
+    if ((int64_t(x) <= g.a) && (g.a < int64_t(x) + dx) && (int64_t(y) <= g.b) && (g.b < int64_t(y) + dy))
+    {
+      sieveArray.set(g.a - x, g.b - y);
+    }
   }
   if ((x <= 1) && (y == 0))
   {
-    sieveArray[1 - x][0] = false; // Crossing off 1
+    sieveArray.reset(1 - x, 0); // Crossing off 1
   }
   if ((y <= 1) && (x == 0))
   {
-    sieveArray[0][1 - y] = false; // Crossing off i
+    sieveArray.reset(0, 1 - y); // Crossing off i
   }
   if (verbose)
   {
@@ -69,75 +81,145 @@ void BlockSieve::setSieveArray()
   }
 }
 
-// Cross off multiples of the gint g = a + bi within the sieveArray.
-// Let a + bi be the gint and c + di be the co-factor of the multiple we seek.
-// We must over integers c and d such that the product (a + bi)(c + di) is
-// contained in the segment block. This gives inequalities x <= ac - bd < x + dx
-// and y <= ad + bc < y + dy. Solve these for c to get
-// (ax + by) / (a^2 + b^2) <= c <= (a(x + dx - 1) + b(y + dy - 1)) / (a^2 + b^2).
-// Then d is defined by some max and min conditions.
+// Cross off multiples of the gint g = a + bi within the sieveArray. The lines
+// of multiples meeting the block are found by forEachLine().
 void BlockSieve::crossOffMultiples(gint g)
 {
+  crossOffRows(g, 0, dy);
+}
 
-  // Convert everything to int64_t type
-  int64_t a = g.a;
-  int64_t b = g.b;
-  int64_t N = g.norm();
-  int64_t c, cUpper;
-  // Trick: to get ceiling of integer division n / m, call (n + m - 1) / m.
-  // This only works when m, n > 0.
-  if (g.b)
-  {
-    c = (a * x + b * y + N - 1) / N; // using trick
-    cUpper = (a * (x + dx - 1) + b * (y + dy - 1)) / N;
-  }
-  else
-  {
-    c = (x + a - 1) / a; // using trick
-    cUpper = (x + dx - 1) / a;
-  }
-  for (; c <= cUpper; c++)
+// Cross off multiples of g within the rows [v0, v1) of the sieveArray.
+void BlockSieve::crossOffRows(gint g, uint32_t v0, uint32_t v1)
+{
+  if (isPresieved(g))
   {
-    int64_t d, dUpper; // d isn't necessarily positive
-    if (b)
-    {
-      // trick doesn't work because of sign; instead using ceil.
-      double d1 = double(a * c - x - dx + 1) / double(b);
-      double d2 = double(y - b * c) / double(a);
-      d = int64_t(ceil(max(d1, d2)));
-      // Reusing d1 and d2
-      d1 = double(a * c - x) / double(b);
-      d2 = double(y + dy - 1 - b * c) / double(a);
-      dUpper = int64_t(floor(min(d1, d2)));
-    }
-    else
-    {
-      d = (y + a - 1) / a; // using trick
-      dUpper = (y + dy - 1) / a;
-    }
+    return;
+  } // multiples already crossed off in setSieveArray()
+  forEachLine(g, x, int64_t(y) + v0, dx, v1 - v0, [&](int64_t a, int64_t b, int64_t c, int64_t d, int64_t dUpper) {
     int32_t u = a * c - b * d - x; // u = ac - bd - x
     int32_t v = b * c + a * d - y; // v = bc + ad - y
     for (; d <= dUpper; d++)
     {
-      sieveArray[u][v] = false;
+      sieveArray.reset(u, v);
       u -= b;
       v += a;
     }
-  }
-  if ((x <= a) && (a < x + dx) && (y <= b) && (b < y + dy))
+  });
+  restorePrime(g, v0, v1);
+}
+
+// Having crossed off the multiples of g within the rows [v0, v1), re-mark g
+// and its flip as prime if they lie in these rows.
+void BlockSieve::restorePrime(gint g, uint32_t v0, uint32_t v1)
+{
+  int64_t y0 = int64_t(y) + v0;
+  int64_t y1 = int64_t(y) + v1;
+  if ((int64_t(x) <= g.a) && (g.a < int64_t(x) + dx) && (y0 <= g.b) && (g.b < y1))
   {
     // crossed this off; need to re-mark it as prime
-    sieveArray[a - x][b - y] = true;
+    sieveArray.set(g.a - x, g.b - y);
   }
-  if ((x <= b) && (b < x + dx) && (y <= a) && (a < y + dy))
+  if ((int64_t(x) <= g.b) && (g.b < int64_t(x) + dx) && (y0 <= g.a) && (g.a < y1))
   {
     // crossed this off; need to re-mark it as prime
-    sieveArray[b - x][a - y] = true;
+    sieveArray.set(g.b - x, g.a - y);
+  }
+}
+
+// Sieve the block a band of rows at a time, so that crossing off stays within
+// a piece of the sieveArray small enough to be held in cache. Primes of norm
+// larger than dx^2 have at most a few multiples on any line within a band, so
+// these are bucket sieved, as in Oliveira e Silva's segmented sieve: each of
+// their lines of multiples is filed under the band holding its next multiple,
+// and is only touched again when that band is sieved. The lines of the other
+// primes are found afresh in every band, which only pays for blocks no wider
+// than a band is tall, like those of VerticalMoat and SegmentedMoat; wider
+// blocks are sieved whole.
+void BlockSieve::sieve()
+{
+  uint32_t height = max(bandBits / dx, uint32_t(64));
+  if ((height < dx) || (height >= dy))
+  {
+    SieveBase::sieve(); // wide blocks, or a single band
+    return;
+  }
+  if (verbose)
+  {
+    cerr << "Starting to sieve in bands of " << height << " rows..." << endl;
+  }
+  auto startTime = chrono::high_resolution_clock::now();
+  // smallPrimes are sorted by norm; the large ones are left to the buckets.
+  uint32_t firstLarge = 0;
+  while ((firstLarge < smallPrimes.size()) && (smallPrimes[firstLarge].norm() <= uint64_t(dx) * dx))
+  {
+    firstLarge++;
+  }
+  vector<vector<BucketEntry>> buckets = fillBandBuckets(firstLarge, height);
+  for (uint32_t band = 0; band < buckets.size(); band++)
+  {
+    uint32_t v0 = band * height;
+    uint32_t v1 = min(uint64_t(v0) + height, uint64_t(dy));
+    for (uint32_t i = 0; i < firstLarge; i++)
+    {
+      crossOffRows(smallPrimes[i], v0, v1);
+    }
+    crossOffBandBucket(buckets, band, height);
+  }
+  for (uint32_t i = firstLarge; i < smallPrimes.size(); i++)
+  {
+    restorePrime(smallPrimes[i], 0, dy);
+  }
+  auto endTime = chrono::high_resolution_clock::now();
+  auto totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+  double printTime = double(totalTime.count()) / 1000.0;
+  if (verbose)
+  {
+    cerr << "\nDone sieving. Total time for sieving: " << printTime << " seconds." << endl;
+  }
+}
+
+// File every line of multiples of the primes of smallPrimes from index
+// firstLarge on under the band of rows of the given height holding its lowest
+// multiple in the block.
+vector<vector<BucketEntry>> BlockSieve::fillBandBuckets(uint32_t firstLarge, uint32_t height)
+{
+  vector<vector<BucketEntry>> buckets((dy - 1) / height + 1);
+  for (uint32_t i = firstLarge; i < smallPrimes.size(); i++)
+  {
+    forEachLine(smallPrimes[i], x, y, dx, dy, [&](int64_t a, int64_t b, int64_t c, int64_t d, int64_t) {
+      buckets[(b * c + a * d - y) / height].push_back({int32_t(a), int32_t(b), int32_t(c), int32_t(d)});
+    });
+  }
+  return buckets;
+}
+
+// Cross off the multiples of large primes within a band. Every line in the
+// bucket of the band is followed until it leaves the band, and is then refiled
+// under the next band it meets, unless it has left the block.
+void BlockSieve::crossOffBandBucket(vector<vector<BucketEntry>> &buckets, uint32_t band, uint32_t height)
+{
+  int64_t top = min(uint64_t(band + 1) * height, uint64_t(dy));
+  for (BucketEntry e : buckets[band])
+  {
+    int64_t u = int64_t(e.a) * e.c - int64_t(e.b) * e.d - x; // u = ac - bd - x
+    int64_t v = int64_t(e.b) * e.c + int64_t(e.a) * e.d - y; // v = bc + ad - y
+    while ((v < top) && (u >= 0) && (u < dx))
+    {
+      sieveArray.reset(u, v);
+      e.d++;
+      u -= e.b;
+      v += e.a;
+    }
+    if ((v < dy) && (u >= 0) && (u < dx))
+    {
+      buckets[v / height].push_back(e);
+    }
   }
+  vector<BucketEntry>().swap(buckets[band]); // done with this band
 }
 
 // Combing through the sieve array to find primes after sieving.
-void BlockSieve::setBigPrimes()
+void BlockSieve::harvestBigPrimes(PrimeSink &sink)
 {
   if (verbose)
   {
@@ -145,14 +227,7 @@ void BlockSieve::setBigPrimes()
   }
   for (uint32_t a = 0; a < dx; a++)
   {
-    for (uint32_t b = 0; b < dy; b++)
-    {
-      if (sieveArray[a][b])
-      {
-        gint g(a + x, b + y);
-        bigPrimes.push_back(g);
-      }
-    }
+    sieveArray.forEach(a, 0, dy, [&](uint32_t b) { sink.push(gint(a + x, b + y)); });
   }
   if (verbose)
   {
@@ -169,13 +244,7 @@ uint64_t BlockSieve::getCountBigPrimes()
   uint64_t count = 0;
   for (uint32_t a = 0; a < dx; a++)
   {
-    for (uint32_t b = 0; b < dy; b++)
-    {
-      if (sieveArray[a][b])
-      {
-        count++;
-      }
-    }
+    count += sieveArray.count(a, 0, dy);
   }
   if (verbose)
   {
@@ -0,0 +1,419 @@
+/* Generate Gaussian primes up to norm x from the rational primes up to x. A
+ * rational prime p = 1 mod 4 is the norm of exactly the eight associates of
+ * a + bi and b + ai for some a > b > 0; a prime q = 3 mod 4 stays prime, with
+ * norm q^2; and 2 is the norm of 1 + i. So only the integers n = 1 mod 4 are
+ * sieved, in segments of segmentSize, by the odd primes up to sqrt(x). Each
+ * survivor p is then split by the Hermite-Serret algorithm: if t^2 = -1 mod p,
+ * the first two remainders below sqrt(p) in Euclid's algorithm on p and t are
+ * a and b.
+ *
+ * Segments are disjoint, so they can be sieved on several threads. Counting
+ * hands out segments from a shared counter; gathering sieves a round of
+ * consecutive segments in parallel and then passes their primes on in order,
+ * so primes always reach the sink in order of norm.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include "CornacchiaSieve.hpp"
+#include "Threads.hpp"
+using namespace std;
+
+CornacchiaSieve::CornacchiaSieve(uint64_t x, bool verbose, uint32_t threads, uint32_t segmentSize)
+    // 8192 bits in a KB
+    : SieveTemplate<bool>(x, verbose),
+      segmentSize(8192 * max(segmentSize, 1u)),
+      threads(threadCount(threads)),
+      segmentStart(1)
+{
+}
+
+// Products are taken in 128 bits only when they can overflow.
+static uint64_t mulMod(uint64_t a, uint64_t b, uint64_t p)
+{
+  if (p >> 32)
+  {
+    return (unsigned __int128)a * b % p;
+  }
+  return a * b % p;
+}
+
+// Multiplication mod an odd p < 2^31 without division, on residues held as
+// a * 2^32 mod p. Every prime split below norm 2^31 goes through here.
+struct Montgomery
+{
+  uint32_t p, pInv; // pInv = -1 / p mod 2^32
+  uint32_t one, r2; // 2^32 mod p and 2^64 mod p
+
+  explicit Montgomery(uint32_t p) : p(p)
+  {
+    uint32_t inv = p; // correct to 3 bits, doubled by each Newton step
+    for (int i = 0; i < 4; i++)
+    {
+      inv *= 2 - p * inv;
+    }
+    pInv = -inv;
+    one = (uint64_t(1) << 32) % p;
+    r2 = uint64_t(one) * one % p;
+  }
+  uint32_t reduce(uint64_t t) const
+  {
+    uint32_t m = uint32_t(t) * pInv;
+    uint64_t r = (t + uint64_t(m) * p) >> 32;
+    return r >= p ? r - p : r;
+  }
+  uint32_t mul(uint32_t a, uint32_t b) const { return reduce(uint64_t(a) * b); }
+  uint32_t pow(uint32_t a, uint64_t e) const
+  {
+    uint32_t r = one;
+    a = reduce(uint64_t(a) * r2);
+    for (; e; e >>= 1)
+    {
+      if (e & 1)
+      {
+        r = mul(r, a);
+      }
+      a = mul(a, a);
+    }
+    return r;
+  }
+};
+
+static uint64_t powMod(uint64_t a, uint64_t e, uint64_t p)
+{
+  uint64_t r = 1;
+  for (; e; e >>= 1)
+  {
+    if (e & 1)
+    {
+      r = mulMod(r, a, p);
+    }
+    a = mulMod(a, a, p);
+  }
+  return r;
+}
+
+// Some quadratic non-residue c mod p. When p = 5 mod 8 this is 2. Otherwise,
+// by quadratic reciprocity, an odd prime c < 64 is a non-residue mod p exactly
+// when p is a non-residue mod c, which is read off a table of squares mod c.
+static uint64_t nonResidue(uint64_t p)
+{
+  if (p % 8 == 5)
+  {
+    return 2;
+  }
+  static const vector<uint64_t> squares = []() {
+    vector<uint64_t> s(64, 0);
+    for (uint64_t c = 3; c < 64; c += 2)
+    {
+      for (uint64_t r = 1; r < c; r++)
+      {
+        s[c] |= uint64_t(1) << (r * r % c);
+      }
+    }
+    return s;
+  }();
+  for (uint64_t c : {3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61})
+  {
+    if (!((squares[c] >> (p % c)) & 1))
+    {
+      return c;
+    }
+  }
+  for (uint64_t c = 67;; c++)
+  {
+    if (powMod(c, (p - 1) / 2, p) == p - 1)
+    {
+      return c;
+    }
+  }
+}
+
+// For a quadratic non-residue c, t = c^((p - 1) / 4) is a square root of -1.
+static uint64_t sqrtMinusOne(uint64_t p)
+{
+  uint64_t c = nonResidue(p);
+  if (p < (uint64_t(1) << 31))
+  {
+    Montgomery m(p);
+    return m.reduce(m.pow(c, (p - 1) / 4));
+  }
+  return powMod(c, (p - 1) / 4, p);
+}
+
+// Euclid's algorithm on p and t, stopping at the first remainder b below
+// sqrt(p); T is wide enough for p.
+template <typename T>
+static gint hermiteSerret(T p, T t)
+{
+  T a = p;
+  T b = t;
+  while (b > p / b)
+  {
+    T r = a % b;
+    a = b;
+    b = r;
+  }
+  return gint(b, a % b);
+}
+
+// 32-bit division is much faster than 64-bit division on most hardware.
+gint CornacchiaSieve::splitPrime(uint64_t p)
+{
+  uint64_t t = sqrtMinusOne(p);
+  if (p >> 32)
+  {
+    return hermiteSerret<uint64_t>(p, t);
+  }
+  return hermiteSerret<uint32_t>(p, t);
+}
+
+// Sieving is deferred to getCountBigPrimes() and harvestBigPrimes(); here we only
+// need the small primes and the memory for a single segment.
+void CornacchiaSieve::run()
+{
+  setSmallPrimes();
+  setSieveArray();
+}
+
+// A plain sieve of Eratosthenes over the odd integers up to sqrt(x).
+void CornacchiaSieve::setSmallPrimes()
+{
+  if (verbose)
+  {
+    cerr << "Sieving rational primes up to sqrt(x) to generate smallPrimes..." << endl;
+  }
+  uint32_t r = isqrt(maxNorm);
+  vector<bool> composite(r + 1, false);
+  smallPrimes.clear();
+  for (uint64_t q = 3; q <= r; q += 2)
+  {
+    if (composite[q])
+    {
+      continue;
+    }
+    smallPrimes.push_back(gint(q, 0));
+    for (uint64_t m = q * q; m <= r; m += 2 * q)
+    {
+      composite[m] = true;
+    }
+  }
+}
+
+void CornacchiaSieve::setSieveArray()
+{
+  setSegment(0);
+  if (verbose)
+  {
+    printSieveArrayInfo();
+  }
+}
+
+uint64_t CornacchiaSieve::getSegmentCount()
+{
+  return maxNorm ? (maxNorm - 1) / (4 * uint64_t(segmentSize)) + 1 : 0;
+}
+
+// Move to segment k and mark every entry as prime. The last segment stops at x.
+void CornacchiaSieve::setSegment(uint64_t k)
+{
+  segmentStart = 1 + 4 * uint64_t(segmentSize) * k;
+  uint64_t height = maxNorm >= segmentStart ? (maxNorm - segmentStart) / 4 + 1 : 0;
+  sieveArray.assign(1, min(uint64_t(segmentSize), height), true);
+  if ((k == 0) && height)
+  {
+    sieveArray.reset(0, 0); // 1 is not prime
+  }
+}
+
+// Cross off multiples of the small primes within the current segment. Only
+// primes up to the square root of the last n in the segment are needed.
+void CornacchiaSieve::sieveSegment()
+{
+  uint32_t height = sieveArray.columnSize(0);
+  if (!height)
+  {
+    return;
+  }
+  uint64_t segmentEnd = segmentStart + 4 * uint64_t(height - 1);
+  for (gint g : smallPrimes)
+  {
+    if (uint64_t(g.a) * g.a > segmentEnd)
+    {
+      break;
+    }
+    crossOffMultiples(g);
+  }
+}
+
+// The multiples qk = 1 mod 4 are those with k = q mod 4, and are 4q apart, so q
+// bits apart in the segment. Crossing off starts at q^2 = 1 mod 4.
+void CornacchiaSieve::crossOffMultiples(gint g)
+{
+  uint64_t q = g.a;
+  uint32_t height = sieveArray.columnSize(0);
+  uint64_t k = max(q, (segmentStart + q - 1) / q);
+  k += (q % 4 + 4 - k % 4) % 4;
+  for (uint64_t v = (q * k - segmentStart) / 4; v < height; v += q)
+  {
+    sieveArray.reset(0, v);
+  }
+}
+
+// Count the primes p = 1 mod 4 within the current segment. If a sink is given,
+// push the primes of the first quadrant above them in order of norm, together
+// with the inert primes q whose norm q^2 falls in the segment.
+uint64_t CornacchiaSieve::gatherSegment(PrimeSink *sink)
+{
+  uint32_t height = sieveArray.columnSize(0);
+  if (!height)
+  {
+    return 0;
+  }
+  if (!sink)
+  {
+    return sieveArray.count(0, 0, height);
+  }
+  uint64_t segmentEnd = segmentStart + 4 * uint64_t(height - 1);
+  // First small prime whose square is in this segment or beyond.
+  auto inert = lower_bound(smallPrimes.begin(), smallPrimes.end(), segmentStart, [](gint g, uint64_t n) {
+    return uint64_t(g.a) * g.a < n;
+  });
+  auto pushInert = [&](uint64_t n) {
+    for (; (inert != smallPrimes.end()) && (uint64_t(inert->a) * inert->a < n); inert++)
+    {
+      if (inert->a % 4 == 3)
+      {
+        sink->push(*inert);
+      }
+    }
+  };
+  uint64_t count = 0;
+  sieveArray.forEach(0, 0, height, [&](uint32_t v) {
+    uint64_t p = segmentStart + 4 * uint64_t(v);
+    pushInert(p);
+    gint g = splitPrime(p);
+    sink->push(g);
+    sink->push(g.flip());
+    count++;
+  });
+  pushInert(segmentEnd + 1);
+  return count;
+}
+
+// Sieve segments, taking the index of the next one from the shared counter
+// until every segment has been taken, and return the number of primes found.
+uint64_t CornacchiaSieve::sweepSegments(atomic<uint64_t> &nextSegment)
+{
+  uint64_t count = 0;
+  uint64_t nSegments = getSegmentCount();
+  for (uint64_t k = nextSegment++; k < nSegments; k = nextSegment++)
+  {
+    setSegment(k);
+    sieveSegment();
+    count += gatherSegment(nullptr);
+  }
+  return count;
+}
+
+// Appends the primes of one worker to a buffer of its own.
+class BufferSink : public PrimeSink
+{
+private:
+  vector<gint> &buffer;
+  void consume(const vector<gint> &primes) override
+  {
+    buffer.insert(buffer.end(), primes.begin(), primes.end());
+  }
+
+public:
+  explicit BufferSink(vector<gint> &buffer) : buffer(buffer) {}
+};
+
+// Rounds of consecutive segments are sieved on the worker threads, each one
+// gathering into a buffer of its own; the buffers are then emptied in order.
+void CornacchiaSieve::harvestBigPrimes(PrimeSink &sink)
+{
+  if (verbose)
+  {
+    cerr << "Gathering primes while sieving " << getSegmentCount()
+         << " segment(s) with " << threads << " thread(s)..." << endl;
+  }
+  if (maxNorm >= 2)
+  {
+    sink.push(gint(1, 1));
+  }
+  uint64_t nSegments = getSegmentCount();
+  if (threads == 1)
+  {
+    for (uint64_t k = 0; k < nSegments; k++)
+    {
+      setSegment(k);
+      sieveSegment();
+      gatherSegment(&sink);
+    }
+  }
+  else
+  {
+    vector<CornacchiaSieve> workers(threads, *this);
+    vector<vector<gint>> buffers(threads);
+    for (uint64_t k = 0; k < nSegments; k += threads)
+    {
+      uint32_t round = uint32_t(min<uint64_t>(threads, nSegments - k));
+      onThreads(round, [&](uint32_t t) {
+        buffers[t].clear();
+        BufferSink buffer(buffers[t]);
+        workers[t].setSegment(k + t);
+        workers[t].sieveSegment();
+        workers[t].gatherSegment(&buffer);
+        buffer.flush();
+      });
+      for (uint32_t t = 0; t < round; t++)
+      {
+        for (gint g : buffers[t])
+        {
+          sink.push(g);
+        }
+      }
+    }
+  }
+  if (verbose)
+  {
+    cerr << "Done gathering." << endl;
+  }
+}
+
+uint64_t CornacchiaSieve::getCountBigPrimes()
+{
+  if (verbose)
+  {
+    cerr << "Counting primes while sieving " << getSegmentCount()
+         << " segment(s) with " << threads << " thread(s)..." << endl;
+  }
+  auto startTime = chrono::high_resolution_clock::now();
+  atomic<uint64_t> nextSegment(0);
+  vector<CornacchiaSieve> workers(threads - 1, *this);
+  vector<uint64_t> counts(threads, 0);
+  onThreads(threads, [&](uint32_t t) { counts[t] = (t ? workers[t - 1] : *this).sweepSegments(nextSegment); });
+  uint64_t split = accumulate(counts.begin(), counts.end(), uint64_t(0));
+  uint64_t inert = 0;
+  for (gint g : smallPrimes)
+  {
+    inert += (g.a % 4 == 3) && (uint64_t(g.a) * g.a <= maxNorm);
+  }
+  // Eight associates above each split prime, four above 2 and each inert prime.
+  uint64_t count = 8 * split + 4 * inert + 4 * (maxNorm >= 2);
+
+  auto endTime = chrono::high_resolution_clock::now();
+  auto totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+  double printTime = double(totalTime.count()) / 1000.0;
+  if (verbose)
+  {
+    cerr << "Done sieving. Total time for sieving: " << printTime << " seconds." << endl;
+    cerr << "Total number of primes, including associates: " << count << "\n"
+         << endl;
+  }
+  return count;
+}
@@ -0,0 +1,38 @@
+/* Hand out Gaussian primes in order of norm, one annulus at a time. Each
+ * annulus [lower, lower + width) is sieved by AnnulusSieve, which takes its
+ * sieving primes from the shared table of SmallPrimes; the table grows as the
+ * annuli move out. Primes of an annulus are radix sorted before any of them is
+ * handed out.
+ */
+
+#include "NormOrderedPrimes.hpp"
+#include "AnnulusSieve.hpp"
+#include "NormSort.hpp"
+using namespace std;
+
+NormOrderedPrimes::NormOrderedPrimes(uint64_t start, uint64_t width)
+    : width(max(width, uint64_t(1))), lower(start), position(0)
+{
+}
+
+void NormOrderedPrimes::sieveNextAnnulus()
+{
+  uint64_t upper = lower + width - 1;
+  AnnulusSieve s(lower, upper, false);
+  s.setSmallPrimes();
+  s.setSieveArray();
+  s.sieve();
+  annulus = s.getBigPrimes(false);
+  radixSortByNorm(annulus, 1);
+  position = 0;
+  lower = upper + 1;
+}
+
+gint NormOrderedPrimes::next()
+{
+  while (position == annulus.size())
+  {
+    sieveNextAnnulus();
+  }
+  return annulus[position++];
+}
@@ -0,0 +1,221 @@
+/* Multi-threaded radix sort of gints by norm. The key of a + bi is
+ *     (a^2 + b^2) << (aBits + 1) | (aMax - a) << 1 | (b < 0),
+ * where aBits is the number of bits needed for aMax - aMin. Comparing keys is
+ * then the same as comparing gints with operator<, and since the norm, the
+ * real part and the sign of the imaginary part are all in the key, each gint
+ * is recovered from its key at the end. Keys take the place of the gints in
+ * the input vector; they are only ever moved in and out of it by memcpy, so
+ * the storage of each gint is never read or written as a uint64_t.
+ *
+ * The keys are first split in place, American flag style, into 2^11 buckets by
+ * the top 11 bits of key - keyMin, so that each bucket holds a contiguous range
+ * of keys. Each bucket is then sorted on its remaining low bits by an LSD radix
+ * sort, 11 bits per pass, with a scratch buffer only as large as the largest
+ * bucket. Norms of primes are spread fairly evenly, so the sort needs little
+ * memory beyond the input, which is what lets the python bindings hand the
+ * input itself to numpy. Buckets are taken by threads from a shared counter.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <memory>
+#include <type_traits>
+#include "NormSort.hpp"
+#include "Threads.hpp"
+using namespace std;
+
+const uint32_t digitBits = 11;
+const uint32_t nDigits = 1 << digitBits;
+
+// A key written over a gint, and read back. The compiler turns each memcpy
+// into a single move.
+static_assert(is_trivially_copyable<gint>::value, "gints are copied as bytes");
+
+static inline void storeKey(gint *g, uint64_t key)
+{
+  memcpy(static_cast<void *>(g), &key, sizeof(key));
+}
+
+static inline uint64_t loadKey(const gint *g)
+{
+  uint64_t key;
+  memcpy(&key, g, sizeof(key));
+  return key;
+}
+
+// Stable LSD radix sort of the n keys from keys, by their offset from keyMin
+// in its lowest bits. The scratch buffer holds at least n keys, and count at
+// least nDigits.
+static void sortLowBits(uint64_t *keys, uint64_t n, uint64_t keyMin, uint32_t bits,
+                        uint64_t *scratch, uint64_t *count)
+{
+  if (n <= 256)
+  {
+    sort(keys, keys + n);
+    return;
+  }
+  uint64_t *src = keys, *dst = scratch;
+  for (uint32_t shift = 0; shift < bits; shift += digitBits)
+  {
+    fill(count, count + nDigits, 0);
+    for (uint64_t i = 0; i < n; i++)
+    {
+      count[((src[i] - keyMin) >> shift) & (nDigits - 1)]++;
+    }
+    if (count[((src[0] - keyMin) >> shift) & (nDigits - 1)] == n)
+    { // every key has the same digit here
+      continue;
+    }
+    uint64_t offset = 0;
+    for (uint32_t d = 0; d < nDigits; d++)
+    {
+      uint64_t c = count[d];
+      count[d] = offset;
+      offset += c;
+    }
+    for (uint64_t i = 0; i < n; i++)
+    {
+      dst[count[((src[i] - keyMin) >> shift) & (nDigits - 1)]++] = src[i];
+    }
+    swap(src, dst);
+  }
+  if (src != keys)
+  {
+    memcpy(keys, src, n * sizeof(uint64_t));
+  }
+}
+
+void radixSortByNorm(vector<gint> &v, uint32_t threads)
+{
+  uint64_t n = v.size();
+  if (n < 2)
+  {
+    return;
+  }
+  threads = threadCount(threads);
+  // Slices shorter than this are not worth starting a thread for.
+  threads = uint32_t(min<uint64_t>(threads, n / (1 << 16) + 1));
+
+  // The ranges of norms and real parts give the length of the keys.
+  uint64_t normMax = 0;
+  int32_t aMin = v[0].a, aMax = v[0].a;
+  for (gint g : v)
+  {
+    normMax = max(normMax, g.norm());
+    aMin = min(aMin, g.a);
+    aMax = max(aMax, g.a);
+  }
+  uint64_t aRange = uint64_t(int64_t(aMax) - aMin);
+  uint32_t aBits = aRange ? 64 - __builtin_clzll(aRange) : 0;
+  uint32_t keyBits = aBits + 1 + (normMax ? 64 - __builtin_clzll(normMax) : 0);
+  if (keyBits > 64)
+  {
+    sort(v.begin(), v.end());
+    return;
+  }
+
+  uint64_t slice = (n + threads - 1) / threads;
+  auto begin = [&](uint32_t t) { return min(n, t * slice); };
+  auto end = [&](uint32_t t) { return min(n, (t + 1) * slice); };
+  static_assert(sizeof(gint) == sizeof(uint64_t), "keys are written over the gints");
+  gint *keys = v.data();
+  vector<uint64_t> keyMins(threads, UINT64_MAX), keyMaxs(threads, 0);
+  onThreads(threads, [&](uint32_t t) {
+    for (uint64_t i = begin(t); i < end(t); i++)
+    {
+      gint g = v[i];
+      uint64_t key = (g.norm() << (aBits + 1)) | (uint64_t(int64_t(aMax) - g.a) << 1) | (g.b < 0);
+      storeKey(keys + i, key);
+      keyMins[t] = min(keyMins[t], key);
+      keyMaxs[t] = max(keyMaxs[t], key);
+    }
+  });
+  uint64_t keyMin = *min_element(keyMins.begin(), keyMins.end());
+  uint64_t spread = *max_element(keyMaxs.begin(), keyMaxs.end()) - keyMin;
+  uint32_t spreadBits = spread ? 64 - __builtin_clzll(spread) : 0;
+  uint32_t shift = spreadBits > digitBits ? spreadBits - digitBits : 0;
+  auto bucket = [&](uint64_t key) { return uint32_t((key - keyMin) >> shift); };
+
+  // counts[nDigits * t + d] is the number of keys in slice t in bucket d.
+  vector<uint64_t> counts(nDigits * threads);
+  onThreads(threads, [&](uint32_t t) {
+    uint64_t *count = &counts[nDigits * t];
+    for (uint64_t i = begin(t); i < end(t); i++)
+    {
+      count[bucket(loadKey(keys + i))]++;
+    }
+  });
+  // Bucket d is keys[start[d]], ..., keys[start[d + 1] - 1].
+  vector<uint64_t> start(nDigits + 1, 0);
+  uint64_t maxBucket = 0;
+  for (uint32_t d = 0; d < nDigits; d++)
+  {
+    uint64_t c = 0;
+    for (uint32_t t = 0; t < threads; t++)
+    {
+      c += counts[nDigits * t + d];
+    }
+    start[d + 1] = start[d] + c;
+    maxBucket = max(maxBucket, c);
+  }
+  // Moving every key to its bucket in place: a key taken from the first
+  // unfilled slot of its bucket displaces the key in the next unfilled slot of
+  // the bucket it belongs to, until a key belonging to the first bucket is
+  // found.
+  vector<uint64_t> next(start.begin(), start.end() - 1);
+  for (uint32_t d = 0; d < nDigits; d++)
+  {
+    while (next[d] < start[d + 1])
+    {
+      uint64_t key = loadKey(keys + next[d]);
+      for (uint32_t e = bucket(key); e != d; e = bucket(key))
+      {
+        uint64_t displaced = loadKey(keys + next[e]);
+        storeKey(keys + next[e]++, key);
+        key = displaced;
+      }
+      storeKey(keys + next[d]++, key);
+    }
+  }
+
+  // Each bucket is copied out to be sorted, so each thread holds two scratch
+  // buffers as large as the largest bucket; fewer threads are used if these
+  // would take more memory than the input.
+  uint32_t bucketThreads = uint32_t(max<uint64_t>(1, min<uint64_t>(threads, n / (2 * maxBucket))));
+  vector<unique_ptr<uint64_t[]>> scratch(bucketThreads), count(bucketThreads);
+  for (uint32_t t = 0; t < bucketThreads; t++)
+  {
+    scratch[t].reset(new uint64_t[2 * maxBucket]); // left uninitialized
+    count[t].reset(new uint64_t[nDigits]);
+  }
+  forEachOnThreads(bucketThreads, nDigits, [&](uint64_t d, uint32_t t) {
+    uint64_t size = start[d + 1] - start[d];
+    uint64_t *bucketKeys = scratch[t].get();
+    memcpy(bucketKeys, keys + start[d], size * sizeof(uint64_t));
+    sortLowBits(bucketKeys, size, keyMin, shift, bucketKeys + maxBucket, count[t].get());
+    memcpy(static_cast<void *>(keys + start[d]), bucketKeys, size * sizeof(uint64_t));
+  });
+
+  // Unpacking the keys into v in place; b is the integer square root of
+  // norm - a^2.
+  uint64_t aMask = (uint64_t(1) << aBits) - 1;
+  onThreads(threads, [&](uint32_t t) {
+    for (uint64_t i = begin(t); i < end(t); i++)
+    {
+      uint64_t key = loadKey(keys + i);
+      int64_t a = int64_t(aMax) - int64_t((key >> 1) & aMask);
+      uint64_t bb = (key >> (aBits + 1)) - uint64_t(a * a);
+      auto b = uint64_t(sqrt(double(bb)));
+      while (b * b > bb)
+      {
+        b--;
+      }
+      while ((b + 1) * (b + 1) <= bb)
+      {
+        b++;
+      }
+      v[i] = gint(int32_t(a), (key & 1) ? -int32_t(b) : int32_t(b));
+    }
+  });
+}
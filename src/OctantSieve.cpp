@@ -4,6 +4,7 @@
 // method to generated small primes.
 #include <iostream>
 #include "OctantSieve.hpp"
+#include "Presieve.hpp"
 using namespace std;
 
 // Generate the small primes using the Sieve of Erathosthenes trick in which
@@ -58,15 +59,27 @@ void OctantSieve::setSieveArray()
   // The x-coord of intersection point between circle a^2 + b^2 <= maxNorm
   // and line a = b.
   uint32_t intersection = isqrt(maxNorm / 2);
+  vector<uint32_t> heights;
   for (uint32_t a = 0; a <= isqrt(x); a++)
   {
-    uint32_t height = a <= intersection ? a + 1 : isqrt(maxNorm - a * a) + 1;
-    // Create a vector of size height with all values true.
-    vector<bool> column(height, true);
-    sieveArray.push_back(column);
+    heights.push_back(a <= intersection ? a + 1 : isqrt(maxNorm - a * a) + 1);
+  }
+  // One contiguous array of columns with the multiples of the pre-sieved
+  // primes already crossed off; this also crosses off 0.
+  sieveArray.assign(heights, true);
+  for (uint32_t a = 0; a < heights.size(); a++)
+  {
+    sieveArray.stamp(a, presieveColumn(a), presieveWords, 0);
+  }
+  sieveArray.reset(1, 0); // 1 is not prime
+  // The pre-sieved primes themselves were crossed off with their multiples.
+  for (gint g : {gint(1, 1), gint(2, 1), gint(3, 0), gint(3, 2)})
+  {
+    if (g.norm() <= maxNorm)
+    {
+      sieveArray.set(g.a, g.b);
+    }
   }
-  sieveArray[0][0] = false; // 0 is not prime
-  sieveArray[1][0] = false; // 1 is not prime
   if (verbose)
   {
     printSieveArrayInfo();
@@ -80,17 +93,22 @@ void OctantSieve::setSieveArray()
 // working with a full octant, the geometry is easy (as opposed to SectorSieve).
 void OctantSieve::crossOffMultiples(gint g)
 {
+  // Multiples already crossed off in setSieveArray().
+  if (isPresieved(g))
+  {
+    return;
+  }
   // Early exit if g isn't actually prime.
   if (g.a >= g.b)
   {
-    if (!sieveArray[g.a][g.b])
+    if (!sieveArray.test(g.a, g.b))
     {
       return;
     }
   }
   else
   {
-    if (!sieveArray[g.b][g.a])
+    if (!sieveArray.test(g.b, g.a))
     {
       return;
     }
@@ -110,22 +128,22 @@ void OctantSieve::crossOffMultiples(gint g)
       {
         if (u >= v)
         { // u + vi already in first octant
-          sieveArray[u][v] = false;
+          sieveArray.reset(u, v);
         }
         else
         { // u + vi in second octant
-          sieveArray[v][u] = false;
+          sieveArray.reset(v, u);
         }
       }
       else
       { // u + vi in second quadrant
         if (v >= -u)
         { // u + vi in third octant
-          sieveArray[v][-u] = false;
+          sieveArray.reset(v, -u);
         }
         else
         { // u + vi in fourth octant
-          sieveArray[-u][v] = false;
+          sieveArray.reset(-u, v);
         }
       }
       u -= g.b;
@@ -136,11 +154,11 @@ void OctantSieve::crossOffMultiples(gint g)
   // c = 1 and d = 0.
   if (g.a > g.b)
   {
-    sieveArray[g.a][g.b] = true;
+    sieveArray.set(g.a, g.b);
   }
   else
   {
-    sieveArray[g.b][g.a] = true;
+    sieveArray.set(g.b, g.a);
   }
   if (verbose)
   {
@@ -149,7 +167,7 @@ void OctantSieve::crossOffMultiples(gint g)
 }
 
 // Stepping through sieveArray and storing unmarked entries as gints.
-void OctantSieve::setBigPrimes()
+void OctantSieve::harvestBigPrimes(PrimeSink &sink)
 {
   if (verbose)
   {
@@ -158,7 +176,7 @@ void OctantSieve::setBigPrimes()
   // Explicitly avoiding ramifying prime 1 + i
   if (maxNorm >= 2)
   {
-    bigPrimes.emplace_back(1, 1);
+    sink.push(gint(1, 1));
   }
 
   uint32_t intersection = isqrt(maxNorm / 2);
@@ -166,18 +184,14 @@ void OctantSieve::setBigPrimes()
   {
     // Can avoid line a = b.
     uint32_t bUpper = a <= intersection ? a - 1 : isqrt(maxNorm - a * a);
-    for (uint32_t b = 0; b <= bUpper; b++)
-    {
-      if (sieveArray[a][b])
-      {
-        gint g(a, b);
-        bigPrimes.push_back(g);
-        if (b)
-        { // prime not on real axis
-          bigPrimes.push_back(g.flip());
-        }
+    sieveArray.forEach(a, 0, bUpper + 1, [&](uint32_t b) {
+      gint g(a, b);
+      sink.push(g);
+      if (b)
+      { // prime not on real axis
+        sink.push(g.flip());
       }
-    }
+    });
   }
   if (verbose)
   {
@@ -204,17 +218,8 @@ uint64_t OctantSieve::getCountBigPrimes()
   {
     // Can avoid line a = b.
     uint32_t bUpper = a <= intersection ? a - 1 : isqrt(maxNorm - a * a);
-    for (uint32_t b = 0; b <= bUpper; b++)
-    {
-      if (sieveArray[a][b])
-      {
-        count++;
-        if (b)
-        { // prime not on real axis; count the flipped version
-          count++;
-        }
-      }
-    }
+    // Primes not on the real axis are counted twice for the flipped version.
+    count += 2 * sieveArray.count(a, 0, bUpper + 1) - sieveArray.test(a, 0);
   }
   count *= 4; // four quadrants
   if (verbose)
@@ -0,0 +1,61 @@
+/* Build the periodic patterns left behind by the pre-sieved primes. Column a
+ * of the boolean pattern holds a bit for each b, set when a^2 + b^2 is coprime
+ * to presieveModulus. Column A of the donut pattern holds the 10 x 10 blocks
+ * with lower left corner 10A + 10Bi, compressed as in OctantDonutSieve. Both
+ * tables are built once, on first use.
+ */
+
+#include <vector>
+#include "Presieve.hpp"
+#include "Donut.hpp"
+using namespace std;
+
+bool isPresieved(gint g)
+{
+  return constexprGcd(g.norm() % presieveModulus, presieveModulus) != 1;
+}
+
+const uint64_t *presieveColumn(uint32_t a)
+{
+  static const vector<uint64_t> pattern = []() {
+    vector<uint64_t> p(presieveModulus * presieveWords, 0);
+    for (uint32_t r = 0; r < presieveModulus; r++)
+    {
+      for (uint32_t b = 0; b < 64 * presieveWords; b++)
+      {
+        if (constexprGcd((r * r + b * b) % presieveModulus, presieveModulus) == 1)
+        {
+          p[r * presieveWords + b / 64] |= uint64_t(1) << (b % 64);
+        }
+      }
+    }
+    return p;
+  }();
+  return pattern.data() + (a % presieveModulus) * presieveWords;
+}
+
+const uint32_t *presieveDonutColumn(uint32_t A)
+{
+  static const vector<uint32_t> pattern = []() {
+    const Donut<10> donut = Donut<10>::make();
+    const uint32_t m = presieveDonutModulus;
+    vector<uint32_t> p(m * m, 0);
+    for (uint32_t R = 0; R < m; R++)
+    {
+      for (uint32_t B = 0; B < m; B++)
+      {
+        for (uint32_t bit = 0; bit < 32; bit++)
+        {
+          uint32_t a = 10 * R + donut.realPart[bit];
+          uint32_t b = 10 * B + donut.imagPart[bit];
+          if (constexprGcd((a * a + b * b) % m, m) == 1)
+          {
+            p[R * m + B] |= 1u << bit;
+          }
+        }
+      }
+    }
+    return p;
+  }();
+  return pattern.data() + (A % presieveDonutModulus) * presieveDonutModulus;
+}
@@ -0,0 +1,98 @@
+/* Count rational primes in the classes 1 and 3 mod 4 with the Lucy_Hedgehog
+ * method. For every v of the form floor(x / n), keep
+ *     S0(v) = #{2 <= m <= v : m has no prime factor below p},
+ *     S1(v) = sum of chi(m) over the same m,
+ * where chi is the non-principal character mod 4. Both are completely
+ * multiplicative weights, so sieving out a prime p updates them by
+ *     S(v) -= f(p) * (S(v / p) - S(p - 1))   for v >= p^2,
+ * with f = 1 for S0 and f = chi for S1. Once p passes sqrt(x), S0(v) = pi(v)
+ * and S1(v) = pi(v; 4, 1) - pi(v; 4, 3). Values v <= sqrt(x) are stored by v
+ * in small[], the others by n = x / v in large[].
+ */
+
+#include <vector>
+#include "PrimeCounting.hpp"
+#include "BaseSieve.hpp"
+using namespace std;
+
+// Tables S0 and S1 of the comment above, after sieving by every p <= sqrt(x).
+struct LucyTables
+{
+  vector<int64_t> small0, small1, large0, large1;
+};
+
+static LucyTables lucy(uint64_t x)
+{
+  uint64_t r = isqrt(x);
+  LucyTables t;
+  t.small0.resize(r + 1);
+  t.small1.resize(r + 1);
+  t.large0.resize(r + 1);
+  t.large1.resize(r + 1);
+  // Partial sums of chi from 1 to v are 1 when v = 1, 2 mod 4 and 0 otherwise.
+  auto chiSum = [](uint64_t v) { return int64_t((v % 4 == 1) || (v % 4 == 2)); };
+  for (uint64_t v = 0; v <= r; v++)
+  {
+    t.small0[v] = int64_t(v) - 1;
+    t.small1[v] = chiSum(v) - 1;
+  }
+  t.small0[0] = t.small1[0] = 0;
+  for (uint64_t n = 1; n <= r; n++)
+  {
+    t.large0[n] = int64_t(x / n) - 1;
+    t.large1[n] = chiSum(x / n) - 1;
+  }
+
+  for (uint64_t p = 2; p <= r; p++)
+  {
+    if (t.small0[p] == t.small0[p - 1])
+    {
+      continue; // p is composite
+    }
+    int64_t chi = p % 4 == 1 ? 1 : p % 4 == 3 ? -1 : 0;
+    int64_t s0 = t.small0[p - 1];
+    int64_t s1 = t.small1[p - 1];
+    uint64_t p2 = p * p;
+    uint64_t nMax = min(r, x / p2);
+    for (uint64_t n = 1; n <= nMax; n++)
+    {
+      uint64_t d = n * p;
+      // x / (np) is stored in large[] if np <= sqrt(x) and in small[] otherwise.
+      int64_t v0 = d <= r ? t.large0[d] : t.small0[x / d];
+      int64_t v1 = d <= r ? t.large1[d] : t.small1[x / d];
+      t.large0[n] -= v0 - s0;
+      t.large1[n] -= chi * (v1 - s1);
+    }
+    for (uint64_t v = r; v >= p2; v--)
+    {
+      t.small0[v] -= t.small0[v / p] - s0;
+      t.small1[v] -= chi * (t.small1[v / p] - s1);
+    }
+  }
+  return t;
+}
+
+pair<uint64_t, uint64_t> countPrimesMod4(uint64_t x)
+{
+  if (x < 3)
+  {
+    return make_pair(0, 0);
+  }
+  LucyTables t = lucy(x);
+  // Neither class contains 2, which is counted in S0 but not in S1.
+  uint64_t odd = t.large0[1] - 1;
+  return make_pair((odd + t.large1[1]) / 2, (odd - t.large1[1]) / 2);
+}
+
+uint64_t countGPrimesToNorm(uint64_t x)
+{
+  if (x < 2)
+  {
+    return 0;
+  }
+  LucyTables t = lucy(x);
+  uint64_t r = isqrt(x);
+  uint64_t split = (t.large0[1] - 1 + t.large1[1]) / 2;
+  uint64_t inert = r < 3 ? 0 : (t.small0[r] - 1 - t.small1[r]) / 2;
+  return 4 + 8 * split + 4 * inert;
+}
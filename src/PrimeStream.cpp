@@ -0,0 +1,119 @@
+/* Stream the primes of a sieve in chunks. The producer thread runs the harvest
+ * into a QueueSink, which gathers the fixed-size chunks of PrimeSink into
+ * chunks of the requested size and queues them. A full queue makes the
+ * producer wait, so it is never more than depth chunks ahead of the consumer.
+ *
+ * When the stream is destroyed before the harvest is over, the producer is
+ * woken and its next attempt to queue a chunk throws Cancelled, which unwinds
+ * the sieve on the producer thread. The harvest must therefore push onto the
+ * sink from the producer thread only, as single-threaded sieves do.
+ */
+
+#include <algorithm>
+#include "PrimeStream.hpp"
+using namespace std;
+
+namespace
+{
+struct Cancelled
+{
+};
+} // namespace
+
+class PrimeStream::QueueSink : public PrimeSink
+{
+private:
+  PrimeStream &stream;
+  vector<gint> pending;
+  void consume(const vector<gint> &primes) override
+  {
+    for (gint g : primes)
+    {
+      pending.push_back(g);
+      if (pending.size() == stream.chunkSize)
+      {
+        stream.enqueue(move(pending));
+        pending = vector<gint>();
+        pending.reserve(stream.chunkSize);
+      }
+    }
+  }
+
+public:
+  explicit QueueSink(PrimeStream &stream) : stream(stream) { pending.reserve(stream.chunkSize); }
+  void finish()
+  {
+    flush();
+    if (!pending.empty())
+    {
+      stream.enqueue(move(pending));
+    }
+  }
+};
+
+PrimeStream::PrimeStream(function<void(PrimeSink &)> harvest, size_t chunkSize, size_t depth)
+    : chunkSize(max(chunkSize, size_t(1))), depth(max(depth, size_t(1))), done(false), cancelled(false)
+{
+  producer = thread([this, harvest]() {
+    try
+    {
+      QueueSink sink(*this);
+      harvest(sink);
+      sink.finish();
+    }
+    catch (Cancelled &)
+    {
+    }
+    catch (...)
+    {
+      lock_guard<mutex> guard(lock);
+      error = current_exception();
+    }
+    lock_guard<mutex> guard(lock);
+    done = true;
+    changed.notify_all();
+  });
+}
+
+PrimeStream::~PrimeStream()
+{
+  {
+    lock_guard<mutex> guard(lock);
+    cancelled = true;
+    changed.notify_all();
+  }
+  producer.join();
+}
+
+// Called on the producer thread; waits for room in the queue.
+void PrimeStream::enqueue(vector<gint> &&chunk)
+{
+  unique_lock<mutex> guard(lock);
+  changed.wait(guard, [this]() { return cancelled || (queue.size() < depth); });
+  if (cancelled)
+  {
+    throw Cancelled();
+  }
+  queue.push_back(move(chunk));
+  changed.notify_all();
+}
+
+vector<gint> PrimeStream::next()
+{
+  unique_lock<mutex> guard(lock);
+  changed.wait(guard, [this]() { return done || !queue.empty(); });
+  if (queue.empty())
+  {
+    if (error)
+    {
+      exception_ptr e = error;
+      error = nullptr;
+      rethrow_exception(e);
+    }
+    return vector<gint>();
+  }
+  vector<gint> chunk = move(queue.front());
+  queue.pop_front();
+  changed.notify_all();
+  return chunk;
+}
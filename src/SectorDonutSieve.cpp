@@ -0,0 +1,395 @@
+/* Perform sieving in the sector defined by norm <= x and alpha <= arg < beta,
+ * keeping only the gints coprime to 10 as in OctantDonutSieve. Must have
+ * x > 0, alpha >= 0, and beta <= pi/2. Cofactors c + di run over the same
+ * sector as in SectorSieve, turned back by the argument of the small prime,
+ * with d jumping through the donut residues for c mod 10. The sector is
+ * bounded by the same integer rays as in SectorSieve, so the two sieves find
+ * exactly the same primes. Given an inner norm x1, columns start at the inner
+ * circle and cofactors of norm below x1 / N(g) are skipped.
+ *
+ * Pieces cut out of the sector by angle would each walk every line of
+ * cofactors of every small prime, however thin the piece, so the threaded
+ * run() cuts the sector by norm instead: the annuli x1 + k (x - x1) / n have
+ * equal area, and each line of cofactors is walked by about one piece.
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include "SectorDonutSieve.hpp"
+#include "SmallPrimes.hpp"
+#include "Presieve.hpp"
+#include "Threads.hpp"
+using namespace std;
+
+constexpr Donut<10> SectorDonutSieve::donut;
+
+// Using an initializer list in the constructor.
+SectorDonutSieve::SectorDonutSieve(
+    uint64_t x, long double alpha, long double beta, bool verbose, uint32_t threads)
+    : SectorDonutSieve(x, alpha, beta, verbose, threads, 0)
+{
+}
+
+SectorDonutSieve::SectorDonutSieve(
+    uint64_t x, long double alpha, long double beta, bool verbose, uint32_t threads, uint64_t x1)
+    : SieveTemplate<uint32_t>(x, verbose), x1(x1), x(x), alpha(min(alpha, beta)),
+      beta(max(alpha, beta)), alphaRay(min(alpha, beta)), betaRay(max(alpha, beta)),
+      threads(threadCount(threads)), A0(0)
+{
+  if ((this->beta > M_PI_2) || (this->alpha < 0))
+  {
+    throw invalid_argument("The interval [alpha, beta) should be a subinterval of [0, pi/2).");
+  }
+  if (x1 > x)
+  {
+    throw invalid_argument("The inner norm x1 should be at most x.");
+  }
+}
+
+// Kept apart from the constructor, whose angles would otherwise take the place
+// of the norms of a call with one argument too many or too few.
+unique_ptr<SectorDonutSieve> SectorDonutSieve::annulus(
+    uint64_t x1, uint64_t x, long double alpha, long double beta, bool verbose, uint32_t threads)
+{
+  return unique_ptr<SectorDonutSieve>(new SectorDonutSieve(x, alpha, beta, verbose, threads, x1));
+}
+
+// One thread runs the usual sieve. Otherwise the small primes are found once,
+// and the workers take annular pieces of the sector from a shared counter.
+void SectorDonutSieve::run()
+{
+  if (threads == 1)
+  {
+    SieveBase::run();
+    return;
+  }
+  setSmallPrimes();
+  pieces.clear();
+  for (const pair<uint64_t, uint64_t> &bounds : equalAreaAnnuli(x1, x, threads))
+  {
+    pieces.push_back(annulus(bounds.first, bounds.second, alpha, beta, false));
+  }
+  if (verbose)
+  {
+    cerr << "Sieving " << pieces.size() << " annular piece(s) with " << threads
+         << " thread(s)..." << endl;
+  }
+  forEachOnThreads(threads, pieces.size(), [&](uint64_t k, uint32_t) {
+    pieces[k]->setSieveArray();
+    for (gint g : smallPrimes)
+    {
+      pieces[k]->crossOffMultiples(g);
+    }
+  });
+  if (verbose)
+  {
+    cerr << "Sieving completed.\n"
+         << endl;
+  }
+}
+
+void SectorDonutSieve::setSmallPrimes()
+{
+  if (verbose)
+  {
+    cerr << "Taking smallPrimes from the shared table..." << endl;
+  }
+  smallPrimes = SmallPrimes::upTo(isqrt(maxNorm)).toVector();
+}
+
+// Column a of gints runs from the ray alpha or the inner circle up to the ray
+// beta or the outer circle, with the bounds used by SectorSieve. The first
+// column meets the inner circle on the ray beta, and the columns end once the
+// ray alpha leaves the outer circle. Column A of words holds every word met by
+// one of the columns a = 10(A0 + A), ..., 10(A0 + A) + 9 of gints.
+void SectorDonutSieve::setSieveArray()
+{
+  if (verbose)
+  {
+    cerr << "Building donut sieve array..." << endl;
+  }
+  // A gint a + bi below the ray beta with a^2 + b^2 >= x1 has
+  // a^2 >= x1 cos^2(beta).
+  A0 = ceilSqrt(betaRay.cosSquaredBelow(x1)) / 10;
+  bLows.clear();
+  bHighs.clear();
+  RayWalk low(alphaRay, 10 * A0);
+  RayWalk high(betaRay, 10 * A0);
+  for (uint64_t a = 10 * A0; a * a <= x; a++, low.next(), high.next())
+  {
+    int64_t outer = floorSqrt(x - a * a);
+    if (low.lowestAbove() > outer)
+    {
+      break;
+    }
+    int64_t inner = a * a >= x1 ? 0 : ceilSqrt(x1 - a * a);
+    bLows.push_back(int32_t(max(low.lowestAbove(), int128_t(inner))));
+    bHighs.push_back(int32_t(min(high.lowestAbove() - 1, int128_t(outer))));
+  }
+  heightShifts.clear();
+  vector<uint32_t> heights;
+  for (uint32_t a0 = 0; a0 < bLows.size(); a0 += 10)
+  {
+    int32_t low = INT32_MAX;
+    int32_t high = -1;
+    for (uint32_t a = a0; a < min(a0 + 10, uint32_t(bLows.size())); a++)
+    {
+      if (bLows[a] <= bHighs[a])
+      {
+        low = min(low, bLows[a]);
+        high = max(high, bHighs[a]);
+      }
+    }
+    heightShifts.push_back(high >= 0 ? low / 10 : 0);
+    heights.push_back(high >= 0 ? high / 10 - low / 10 + 1 : 0);
+  }
+  sieveArray.assign(heights, UINT32_MAX); // all ones in binary representation
+  // Stamp out multiples of the pre-sieved primes not already left out of the
+  // donut, then put back the primes 3, 3 + 2i and 2 + 3i themselves.
+  for (uint32_t A = 0; A < heights.size(); A++)
+  {
+    sieveArray.stamp(A, presieveDonutColumn(A0 + A), presieveDonutModulus, heightShifts[A]);
+  }
+  for (gint g : {gint(3, 0), gint(3, 2), gint(2, 3)})
+  {
+    if (inSector(g.a, g.b))
+    {
+      setTrue(g.a, g.b);
+    }
+  }
+  if (inSector(1, 0))
+  {
+    setFalse(1, 0); // 1 is not prime
+  }
+  if (verbose)
+  {
+    printSieveArrayInfo();
+  }
+}
+
+bool SectorDonutSieve::inSector(uint32_t a, uint32_t b)
+{
+  uint32_t u = a - 10 * A0;
+  return (a >= 10 * A0) && (u < bLows.size()) && (int32_t(b) >= bLows[u]) &&
+         (int32_t(b) <= bHighs[u]);
+}
+
+// First word of column A lying wholly inside the sector, in every column of
+// gints a = 10(A0 + A), ..., 10(A0 + A) + 9.
+uint32_t SectorDonutSieve::getInteriorBegin(uint32_t A)
+{
+  if (10 * A + 10 > bLows.size())
+  {
+    return UINT32_MAX;
+  }
+  int32_t low = *max_element(bLows.begin() + 10 * A, bLows.begin() + 10 * A + 10);
+  return (low + 9) / 10;
+}
+
+// One past the last word of column A lying wholly inside the sector.
+uint32_t SectorDonutSieve::getInteriorEnd(uint32_t A)
+{
+  if (10 * A + 10 > bLows.size())
+  {
+    return 0;
+  }
+  int32_t high = *min_element(bHighs.begin() + 10 * A, bHighs.begin() + 10 * A + 10);
+  return high >= 9 ? (high - 9) / 10 + 1 : 0;
+}
+
+void SectorDonutSieve::crossOffMultiples(gint g)
+{
+  // Multiples already left out of the donut or stamped out in setSieveArray().
+  if (isPresieved(g))
+  {
+    return;
+  }
+  // Cofactors run over the sector turned back by arg(g), as in SectorSieve,
+  // between the circles of norm lo and hi.
+  uint64_t N = g.norm();
+  uint64_t lo = max((x1 + N - 1) / N, uint64_t(1)); // ignoring c, d = 0, 0
+  uint64_t hi = x / N;
+  if (lo > hi)
+  {
+    return; // no multiple of g lies in the sieve array
+  }
+  Ray lowRay = alphaRay.turnedBack(g);
+  Ray highRay = betaRay.turnedBack(g);
+  // Cofactors of norm at least lo have c >= sqrt(lo) cos(theta), where theta
+  // lies between the angles of the turned rays; cos is least at one of them.
+  uint64_t c = 1;
+  if (lo > 1)
+  {
+    long double pLow = lowRay.p, qLow = lowRay.q, pHigh = highRay.p, qHigh = highRay.q;
+    long double cosLow = pLow / sqrtl(pLow * pLow + qLow * qLow);
+    long double cosHigh = pHigh / sqrtl(pHigh * pHigh + qHigh * qHigh);
+    c = max(int64_t(sqrtl(lo) * min(cosLow, cosHigh)) - 1, int64_t(1));
+  }
+  RayWalk low(lowRay, c);
+  RayWalk high(highRay, c);
+  int64_t outer = c * c <= hi ? floorSqrt(hi - c * c) : 0;
+  int64_t inner = c * c >= lo ? 0 : ceilSqrt(lo - c * c);
+  for (; c * c <= hi; c++, low.next(), high.next())
+  {
+    if (c * c + uint64_t(outer * outer) > hi)
+    {
+      outer = floorSqrt(hi - c * c);
+    }
+    if ((inner > 0) && (c * c + uint64_t((inner - 1) * (inner - 1)) >= lo))
+    {
+      inner = ceilSqrt(c * c >= lo ? 0 : lo - c * c);
+    }
+    int128_t lowest = low.lowestAbove();
+    int128_t highest = high.lowestAbove() - 1;
+    // Once the sector has left the disk on one side, no later line meets it.
+    if (((lowRay.q >= 0) && (lowest > outer)) || ((highRay.q <= 0) && (highest < -outer)))
+    {
+      break;
+    }
+    if (inner == 0)
+    {
+      crossOffLine(g, c, max(lowest, int128_t(-outer)), min(highest, int128_t(outer)));
+    }
+    else
+    { // the line crosses the inner disk, leaving a segment below and above it
+      crossOffLine(g, c, max(lowest, int128_t(-outer)), min(highest, int128_t(-inner)));
+      crossOffLine(g, c, max(lowest, int128_t(inner)), min(highest, int128_t(outer)));
+    }
+  }
+  // Checking if gint in sieve array so we can uncross it.
+  if (inSector(g.a, g.b))
+  {
+    setTrue(g.a, g.b);
+  }
+  if (verbose)
+  {
+    printProgress(g);
+  }
+}
+
+// Cross off the multiples g (c + di) with d0 <= d <= d1 and c + di in the donut.
+void SectorDonutSieve::crossOffLine(gint g, uint32_t c, int128_t d0, int128_t d1)
+{
+  if (d0 > d1)
+  {
+    return; // thin sectors miss most lines
+  }
+  int32_t d = int32_t(d0);
+  int32_t dUpper = int32_t(d1);
+  // first d with c + di in the donut; d may be negative
+  while (!donut.gap[c % 10][(d % 10 + 10) % 10])
+  {
+    d++;
+  }
+  int32_t u = g.a * c - g.b * d; // u = ac - bd
+  int32_t v = g.b * c + g.a * d; // v = bc + ad
+  while (d <= dUpper)
+  {
+    setFalse(uint32_t(u), uint32_t(v));
+    uint32_t jump = donut.gap[c % 10][(d % 10 + 10) % 10];
+    d += jump;
+    u -= jump * g.b;
+    v += jump * g.a;
+  }
+}
+
+void SectorDonutSieve::setFalse(uint32_t u, uint32_t v)
+{
+  uint32_t A = u / 10 - A0;
+  sieveArray[A][v / 10 - heightShifts[A]] &= ~(1u << donut.bit[u % 10][v % 10]);
+}
+
+void SectorDonutSieve::setTrue(uint32_t u, uint32_t v)
+{
+  uint32_t A = u / 10 - A0;
+  sieveArray[A][v / 10 - heightShifts[A]] |= 1u << donut.bit[u % 10][v % 10];
+}
+
+void SectorDonutSieve::harvestBigPrimes(PrimeSink &sink)
+{
+  if (verbose)
+  {
+    cerr << "Gathering primes after sieve..." << endl;
+  }
+  for (auto &piece : pieces)
+  {
+    piece->harvestBigPrimes(sink);
+  }
+  // Putting in primes dividing 10.
+  for (gint g : {gint(1, 1), gint(2, 1), gint(1, 2)})
+  {
+    if (inSector(g.a, g.b))
+    {
+      sink.push(g);
+    }
+  }
+  for (uint32_t A = 0; A < sieveArray.size(); A++)
+  {
+    uint32_t begin = getInteriorBegin(A);
+    uint32_t end = getInteriorEnd(A);
+    for (uint32_t B = 0; B < sieveArray.columnSize(A); B++)
+    {
+      uint32_t W = B + heightShifts[A];
+      bool interior = (W >= begin) && (W < end);
+      for (uint32_t word = sieveArray[A][B]; word; word &= word - 1)
+      {
+        uint32_t bit = __builtin_ctz(word);
+        gint g(10 * (A0 + A) + donut.realPart[bit], 10 * W + donut.imagPart[bit]);
+        // check for words on the rays or the boundary circle
+        if (interior || inSector(g.a, g.b))
+        {
+          sink.push(g);
+        }
+      }
+    }
+  }
+  if (verbose)
+  {
+    cerr << "Done with gathering.\n"
+         << endl;
+  }
+}
+
+uint64_t SectorDonutSieve::getCountBigPrimes()
+{
+  if (verbose)
+  {
+    cerr << "Counting primes after sieve..." << endl;
+  }
+  uint64_t count = 0;
+  for (auto &piece : pieces)
+  {
+    count += piece->getCountBigPrimes();
+  }
+  for (gint g : {gint(1, 1), gint(2, 1), gint(1, 2)})
+  {
+    count += inSector(g.a, g.b);
+  }
+  for (uint32_t A = 0; A < sieveArray.size(); A++)
+  {
+    const uint32_t *column = sieveArray[A];
+    uint32_t begin = getInteriorBegin(A);
+    uint32_t end = getInteriorEnd(A);
+    for (uint32_t B = 0; B < sieveArray.columnSize(A); B++)
+    {
+      uint32_t W = B + heightShifts[A];
+      // Interior words are counted with popcount.
+      if ((W >= begin) && (W < end))
+      {
+        count += __builtin_popcount(column[B]);
+        continue;
+      }
+      for (uint32_t word = column[B]; word; word &= word - 1)
+      {
+        uint32_t bit = __builtin_ctz(word);
+        count += inSector(10 * (A0 + A) + donut.realPart[bit], 10 * W + donut.imagPart[bit]);
+      }
+    }
+  }
+  if (verbose)
+  {
+    cerr << "Total number of primes in sector: " << count << "\n"
+         << endl;
+  }
+  return count;
+}
@@ -0,0 +1,253 @@
+/* Tally races between sectors without keeping their primes. The angles of all
+ * sectors cut the quarter plane into cells, bounded by the same integer rays
+ * as in SectorDonutSieve; a prime lies in the sector from ray i up to ray j
+ * exactly when its cell is among i, ..., j - 1, so each harvested prime is put
+ * in its cell by a binary search of cross products, and is counted in the
+ * histogram of that cell by norm. Once an annulus is done, the histograms of
+ * its cells are added to or taken from the norm data of every race, which is
+ * then only a matter of cells and bins, however many primes there were.
+ *
+ * Annuli of a group only touch the bins of their own range of norms, so each
+ * worker holds the histograms of one annulus at a time, and adds them to the
+ * shared norm data under a lock. As in SectorDonutSieve::run, two annuli per
+ * thread keep the workers busy, while no annulus holds more than 2^32 norms.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include "SectorRaces.hpp"
+#include "SectorDonutSieve.hpp"
+#include "Threads.hpp"
+using namespace std;
+
+SectorRaces::SectorRaces(
+    uint64_t x,
+    uint64_t nBins,
+    const vector<array<long double, 4>> &races,
+    bool keepPrimes,
+    bool verbose,
+    uint32_t threads)
+    : x(x),
+      nBins(nBins),
+      races(races),
+      keepPrimes(keepPrimes),
+      verbose(verbose),
+      threads(threadCount(threads))
+{
+  if (!x || !nBins)
+  {
+    throw invalid_argument("The norm bound and the number of bins should be positive.");
+  }
+  for (const array<long double, 4> &race : races)
+  {
+    for (long double angle : race)
+    {
+      if ((angle < 0) || (angle > M_PI_2))
+      {
+        throw invalid_argument("Every angle of a race should lie in [0, pi/2].");
+      }
+      angles.push_back(angle);
+    }
+  }
+  sort(angles.begin(), angles.end());
+  angles.erase(unique(angles.begin(), angles.end()), angles.end());
+  for (long double angle : angles)
+  {
+    boundaries.emplace_back(angle);
+  }
+  // Bounds of each sector taken in increasing order, as in SectorDonutSieve.
+  auto index = [&](long double angle) {
+    return uint32_t(lower_bound(angles.begin(), angles.end(), angle) - angles.begin());
+  };
+  for (const array<long double, 4> &race : races)
+  {
+    for (uint32_t side = 0; side < 4; side += 2)
+    {
+      sectorBegin.push_back(index(min(race[side], race[side + 1])));
+      sectorEnd.push_back(index(max(race[side], race[side + 1])));
+    }
+  }
+}
+
+// The cell of a gint known to lie between rays begin and end.
+uint32_t SectorRaces::cellOf(gint g, uint32_t begin, uint32_t end) const
+{
+  while (end - begin > 1)
+  {
+    uint32_t middle = begin + (end - begin) / 2;
+    if (boundaries[middle].isOnOrAbove(g.a, g.b))
+    {
+      begin = middle;
+    }
+    else
+    {
+      end = middle;
+    }
+  }
+  return begin;
+}
+
+void SectorRaces::run()
+{
+  uint32_t nSectors = sectorBegin.size();
+  // Groups of rays spanned by overlapping or touching sectors; empty sectors
+  // hold no primes and are left out.
+  vector<uint32_t> order;
+  for (uint32_t j = 0; j < nSectors; j++)
+  {
+    if (sectorBegin[j] < sectorEnd[j])
+    {
+      order.push_back(j);
+    }
+  }
+  sort(order.begin(), order.end(), [&](uint32_t i, uint32_t j) { return sectorBegin[i] < sectorBegin[j]; });
+  vector<pair<uint32_t, uint32_t>> groups;
+  vector<vector<uint32_t>> groupSectors;
+  for (uint32_t j : order)
+  {
+    if (groups.empty() || (sectorBegin[j] > groups.back().second))
+    {
+      groups.emplace_back(sectorBegin[j], sectorEnd[j]);
+      groupSectors.emplace_back();
+    }
+    groups.back().second = max(groups.back().second, sectorEnd[j]);
+    groupSectors.back().push_back(j);
+  }
+
+  // Annuli of equal area in every group.
+  struct Piece
+  {
+    uint32_t group;
+    uint64_t lower, upper;
+  };
+  vector<Piece> pieces;
+  vector<pair<uint64_t, uint64_t>> annuli = equalAreaAnnuli(0, x, threads);
+  for (uint32_t group = 0; group < groups.size(); group++)
+  {
+    for (const pair<uint64_t, uint64_t> &bounds : annuli)
+    {
+      pieces.push_back({group, bounds.first, bounds.second});
+    }
+  }
+
+  if (verbose)
+  {
+    cerr << "Taking smallPrimes from the shared table..." << endl;
+  }
+  SmallPrimes::View smallPrimes = SmallPrimes::upTo(isqrt(x));
+  if (verbose)
+  {
+    cerr << "Sieving " << groups.size() << " group(s) of sectors for " << races.size()
+         << " race(s) in " << pieces.size() << " annular piece(s) with " << threads
+         << " thread(s)..." << endl;
+  }
+
+  normData.assign(races.size(), vector<int64_t>(nBins, 0));
+  vector<vector<vector<gint>>> piecePrimes(keepPrimes ? pieces.size() : 0);
+  auto binOf = [&](uint64_t norm) {
+    return min(uint64_t((unsigned __int128)(norm)*nBins / x), nBins - 1);
+  };
+  mutex lock;
+  forEachOnThreads(threads, pieces.size(), [&](uint64_t k, uint32_t) {
+    const Piece &piece = pieces[k];
+    uint32_t begin = groups[piece.group].first;
+    uint32_t end = groups[piece.group].second;
+    unique_ptr<SectorDonutSieve> s = SectorDonutSieve::annulus(piece.lower, piece.upper, angles[begin], angles[end], false);
+    s->setSieveArray();
+    uint32_t bound = isqrt(piece.upper);
+    for (gint g : smallPrimes)
+    {
+      if (g.norm() > bound)
+      {
+        break;
+      }
+      s->crossOffMultiples(g);
+    }
+    // Histograms of the cells of the group over the bins of the annulus.
+    uint64_t binBegin = binOf(piece.lower);
+    uint64_t width = binOf(piece.upper) - binBegin + 1;
+    vector<int64_t> tally(uint64_t(end - begin) * width, 0);
+    vector<vector<gint>> primes(keepPrimes ? nSectors : 0);
+    s->visitBigPrimes([&](const vector<gint> &chunk) {
+      for (gint g : chunk)
+      {
+        uint32_t cell = cellOf(g, begin, end);
+        tally[(cell - begin) * width + binOf(g.norm()) - binBegin]++;
+        if (keepPrimes)
+        {
+          for (uint32_t j : groupSectors[piece.group])
+          {
+            if ((sectorBegin[j] <= cell) && (cell < sectorEnd[j]))
+            {
+              primes[j].push_back(g);
+            }
+          }
+        }
+      }
+    });
+    lock_guard<mutex> guard(lock);
+    for (uint32_t j : groupSectors[piece.group])
+    {
+      vector<int64_t> &data = normData[j / 2];
+      int64_t sign = j % 2 ? -1 : 1; // the second sector of a race counts against it
+      for (uint32_t cell = sectorBegin[j]; cell < sectorEnd[j]; cell++)
+      {
+        const int64_t *counts = &tally[(cell - begin) * width];
+        for (uint64_t i = 0; i < width; i++)
+        {
+          data[binBegin + i] += sign * counts[i];
+        }
+      }
+    }
+    if (keepPrimes)
+    {
+      piecePrimes[k] = move(primes);
+    }
+  });
+
+  for (vector<int64_t> &data : normData)
+  {
+    partial_sum(data.begin(), data.end(), data.begin());
+  }
+  // The primes of each sector, gathered piece by piece in order of norm.
+  sectorPrimes.assign(keepPrimes ? nSectors : 0, vector<gint>());
+  for (vector<vector<gint>> &primes : piecePrimes)
+  {
+    for (uint32_t j = 0; j < primes.size(); j++)
+    {
+      sectorPrimes[j].insert(sectorPrimes[j].end(), primes[j].begin(), primes[j].end());
+      vector<gint>().swap(primes[j]);
+    }
+  }
+  if (verbose)
+  {
+    cerr << "Done with races.\n"
+         << endl;
+  }
+}
+
+const vector<int64_t> &SectorRaces::getNormData(uint32_t race) const
+{
+  return normData.at(race);
+}
+
+const vector<gint> &SectorRaces::getSectorPrimes(uint32_t sector) const
+{
+  if (!keepPrimes)
+  {
+    throw invalid_argument("The primes of each sector are only kept when asked for.");
+  }
+  return sectorPrimes.at(sector);
+}
+
+vector<gint> SectorRaces::takeSectorPrimes(uint32_t sector)
+{
+  if (!keepPrimes)
+  {
+    throw invalid_argument("The primes of each sector are only kept when asked for.");
+  }
+  return move(sectorPrimes.at(sector));
+}
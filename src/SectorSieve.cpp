@@ -1,10 +1,13 @@
 /* Perform sieving in the sector defined by norm <= x and alpha <= arg < beta.
- * Must have x > 0, alpha >= 0, and beta <= pi/4.
+ * Must have x > 0, alpha >= 0, and beta <= pi/2. The rays alpha and beta are
+ * held as integer direction vectors (see Ray.hpp), and every bound on the
+ * sieve array and on the cofactors is found from these by exact integer
+ * arithmetic; no trigonometry is done after the constructor.
  */
 
 #include <iostream>
 #include <cmath>
-#include "OctantSieve.hpp"
+#include "SmallPrimes.hpp"
 #include "SectorSieve.hpp"
 using namespace std;
 
@@ -16,6 +19,8 @@ SectorSieve::SectorSieve(uint64_t x, long double alpha, long double beta, bool v
       alpha(alpha) // beginning angle of sector
       ,
       beta(beta) // final angle of sector
+      ,
+      alphaRay(min(alpha, beta)), betaRay(max(alpha, beta))
 {
   if (beta < alpha)
   { // the order of alpha and beta doesn't matter; corrected here
@@ -31,24 +36,18 @@ SectorSieve::SectorSieve(uint64_t x, long double alpha, long double beta, bool v
 
 void SectorSieve::setSmallPrimes()
 {
-  // Setting smallPrimes to the output of QuadrantSieve, which can generate
-  // its own small primes.
   if (verbose)
   {
-    cerr << "Calling the OctantSieve to generate smallPrimes..." << endl;
+    cerr << "Taking smallPrimes from the shared table..." << endl;
   }
-  OctantSieve s((uint64_t)isqrt(maxNorm), false);
-  s.run();
-  smallPrimes = s.getBigPrimes();
+  smallPrimes = SmallPrimes::upTo(isqrt(maxNorm)).toVector();
 }
 
-// Involves many intersections.
-// The annular sector is bounded by the equations
-// x^2 + y^2 = maxNorm
-// y = tan(alpha) x
-// y = tan(beta) x
-// Note that the state of the gaussian integer u + iv with in sieveArray is
-// given by sieveArray[u][v - floor(tan(alpha) * u)]
+// The annular sector is bounded by the circle a^2 + b^2 = maxNorm and the two
+// rays. Column a of the sieve array holds the gints a + bi on or above the ray
+// alpha, strictly below the ray beta, and inside the circle; the state of u + vi
+// is given by sieveArray[u][v - heightShifts[u]]. Lowest points only rise with
+// a, so columns stop once the lowest point leaves the disk.
 void SectorSieve::setSieveArray()
 {
   // sieveArray holds values for gint's with a, b >= 0
@@ -56,33 +55,23 @@ void SectorSieve::setSieveArray()
   {
     cerr << "Building sieve array..." << endl;
   }
-  // Putting something in at a = 0, and crossing that something off.
-  heightShifts.push_back(1);
-  sieveArray.emplace_back(1, false);
-
-  for (uint64_t a = 1; a <= isqrt(x / (1 + pow(tan(alpha), 2))); a++)
+  heightShifts.clear();
+  vector<uint32_t> heights;
+  for (uint64_t a = 0; a * a <= x; a++)
   {
-    // Vertical offset from y-axis to sector.
-    heightShifts.push_back(int32_t(ceil(tan(alpha) * a - tolerance)));
-
-    // a-value of intersection
-    uint64_t intersection = isqrt(x / (1 + pow(tan(beta), 2)));
-    int32_t b; // represents the height of the column at a in sieveArray
-    if (a <= intersection)
+    int128_t low = alphaRay.lowestAbove(a);
+    if ((low > isqrt(x)) || (a * a + uint64_t(low * low) > x))
     {
-      // Do not include any point on the ray theta = beta.
-      b = int32_t(floor(tan(beta) * a + tolerance)) - heightShifts[a] + 1;
+      break;
     }
-    else
-    {
-      b = isqrt(x - a * a) - heightShifts[a] + 1;
-    }
-    vector<bool> column(uint32_t(b), true); // Create a vector of size b with all values true.
-    sieveArray.push_back(column);
+    int64_t high = int64_t(min(betaRay.lowestAbove(a) - 1, int128_t(isqrt(x - a * a))));
+    heightShifts.push_back(int32_t(low));
+    heights.push_back(high >= low ? high - low + 1 : 0);
   }
-  if (alpha == 0)
+  sieveArray.assign(heights, true);
+  if (inSector(gint(1, 0)))
   {
-    sieveArray[1][0] = false; // crossing off 1 (it's not prime)
+    sieveArray.reset(1, 0); // crossing off 1 (it's not prime)
   }
   if (verbose)
   {
@@ -90,48 +79,54 @@ void SectorSieve::setSieveArray()
   }
 }
 
+// Is a + bi, with a, b >= 0, in the sieve array.
+bool SectorSieve::inSector(gint g)
+{
+  return (uint32_t(g.a) < sieveArray.size()) && (g.b >= heightShifts[g.a]) &&
+         (uint32_t(g.b - heightShifts[g.a]) < sieveArray.columnSize(g.a));
+}
+
 void SectorSieve::crossOffMultiples(gint g)
 {
-  // First form a mini sector indexed by c and d. Imagining this sector as a
-  // slice of pizza, there are three possible configurations for which point
-  // on the pizza with tip at origin has largest x-value.
-  uint64_t intersectionc1 = isqrt(x / (g.norm() * (1 + pow(tan(beta - g.arg()), 2))));
-  uint64_t intersectionc2 = isqrt(x / (g.norm() * (1 + pow(tan(alpha - g.arg()), 2))));
-  uint64_t maxIntersectionc = max(intersectionc1, intersectionc2);
-  uint64_t cUpper = max(maxIntersectionc, (uint64_t)isqrt(x / g.norm()));
+  // The cofactors c + di of multiples in the sector lie on or above the ray
+  // alpha and strictly below the ray beta, both turned back by arg(g), and
+  // have norm at most x / N(g). Heights of the rays on each line c are found
+  // with additions, and the circle is followed as in OctantSieve.
+  uint64_t hi = x / g.norm();
+  Ray lowRay = alphaRay.turnedBack(g);
+  Ray highRay = betaRay.turnedBack(g);
+  RayWalk low(lowRay, 1);
+  RayWalk high(highRay, 1);
+  int64_t outer = isqrt(hi);
   // Using 64 bits for c since we'll need to square it below.
-  for (uint64_t c = 1; c <= cUpper; c++)
+  for (uint64_t c = 1; c * c <= hi; c++, low.next(), high.next())
   { //ignoring c, d = 0, 0
-    int32_t d = ceil(max(tan(alpha - g.arg()) * c - tolerance, -(long double)sqrt(x / g.norm() - c * c)));
-    // Subtract tolerance since arg(z) strictly less than beta.
-    int32_t dUpper = floor(min(tan(beta - g.arg()) * c - tolerance, (long double)sqrt(x / g.norm() - c * c)));
+    while (c * c + uint64_t(outer * outer) > hi)
+    {
+      outer--;
+    }
+    int128_t lowest = low.lowestAbove();
+    int128_t highest = high.lowestAbove() - 1;
+    // Once the sector has left the disk on one side, no later line meets it.
+    if (((lowRay.q >= 0) && (lowest > outer)) || ((highRay.q <= 0) && (highest < -outer)))
+    {
+      break;
+    }
+    int32_t d = int32_t(max(lowest, int128_t(-outer)));
+    int32_t dUpper = int32_t(min(highest, int128_t(outer)));
     int32_t u = g.a * c - g.b * d; // u = ac - bd
     int32_t v = g.b * c + g.a * d; // v = bc + ad
     for (; d <= dUpper; d++)
     {
-      try
-      {                                                                       // round-off error may make this go out of bounds
-        sieveArray.at(uint32_t(u)).at(uint32_t(v - heightShifts[u])) = false; // get back into sieve array
-      }
-      catch (const out_of_range &e)
-      {
-        cerr << "Out of range error!" << endl;
-        cerr << "a, b = " << g.a << ", " << g.b << endl;
-        cerr << "u, v = " << u << ", " << v << endl;
-        cerr << "heightShifts[u] = " << heightShifts[u] << endl;
-        cerr << "c, cUpper = " << c << ", " << cUpper << endl;
-        cerr << "d, dUpper = " << d << ", " << dUpper << endl;
-        cerr << "length of column at u: " << sieveArray[u].size() << endl;
-        exit(1);
-      }
+      sieveArray.reset(u, v - heightShifts[u]); // get back into sieve array
       u -= g.b;
       v += g.a;
     }
   }
-  // Checking if gint in sieve array so we can cross it off.
-  if ((g.arg() >= alpha) && (g.arg() < beta) && (g.norm() <= x))
+  // Checking if gint in sieve array so we can uncross it.
+  if (inSector(g))
   {
-    sieveArray[g.a][g.b - tan(alpha) * g.a] = true;
+    sieveArray.set(g.a, g.b - heightShifts[g.a]);
   }
   if (verbose)
   {
@@ -139,33 +134,18 @@ void SectorSieve::crossOffMultiples(gint g)
   }
 }
 
-void SectorSieve::setBigPrimes()
+void SectorSieve::harvestBigPrimes(PrimeSink &sink)
 {
   if (verbose)
   {
     cerr << "Gathering primes after sieve..." << endl;
   }
-  for (uint64_t a = 0; a <= isqrt(x / (1 + pow(tan(alpha), 2))); a++)
+  for (uint32_t a = 0; a < sieveArray.size(); a++)
   {
-    // a-value of intersection
-    uint64_t intersection = isqrt(x / (1 + pow(tan(beta), 2)));
-    int32_t bUpper; // represents the height of the column at a in sieveArray
-    if (a <= intersection)
-    {
-      bUpper = int32_t(tan(beta) * a) - heightShifts[a];
-    }
-    else
-    {
-      bUpper = isqrt(x - a * a) - heightShifts[a];
-    }
-    for (int32_t b = 0; b <= bUpper; b++)
-    {
-      if (sieveArray[a][b])
-      {
-        gint g(a, uint32_t(b + heightShifts[a])); // pushing back up into actual sector
-        bigPrimes.push_back(g);
-      }
-    }
+    sieveArray.forEach(a, 0, sieveArray.columnSize(a), [&](uint32_t b) {
+      gint g(a, b + heightShifts[a]); // pushing back up into actual sector
+      sink.push(g);
+    });
   }
   if (verbose)
   {
@@ -181,26 +161,9 @@ uint64_t SectorSieve::getCountBigPrimes()
     cerr << "Counting primes after sieve..." << endl;
   }
   uint64_t count = 0;
-  for (uint64_t a = 0; a <= isqrt(x / (1 + pow(tan(alpha), 2))); a++)
+  for (uint32_t a = 0; a < sieveArray.size(); a++)
   {
-    // a-value of intersection
-    uint64_t intersection = isqrt(x / (1 + pow(tan(beta), 2)));
-    int32_t bUpper; // represents the height of the column at a in sieveArray
-    if (a <= intersection)
-    {
-      bUpper = int32_t(tan(beta) * a) - heightShifts[a];
-    }
-    else
-    {
-      bUpper = isqrt(x - a * a) - heightShifts[a];
-    }
-    for (int32_t b = 0; b <= bUpper; b++)
-    {
-      if (sieveArray[a][b])
-      {
-        count++;
-      }
-    }
+    count += sieveArray.count(a, 0, sieveArray.columnSize(a));
   }
   if (verbose)
   {
@@ -208,4 +171,4 @@ uint64_t SectorSieve::getCountBigPrimes()
          << endl;
   }
   return count;
-}
\ No newline at end of file
+}
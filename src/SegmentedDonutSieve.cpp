@@ -0,0 +1,421 @@
+/* Perform the octant donut sieve up to norm x one tile at a time. The donut
+ * array of OctantDonutSieve is covered by square tiles of tileSize x tileSize
+ * words, swept in vertical strips from left to right. Every small prime is
+ * crossed off within a tile before moving on to the next one, so the working
+ * set stays in cache and memory use is O(sqrt(x)) plus one tile.
+ *
+ * Strips of tiles are disjoint, so they can be handed out to several threads.
+ * Every worker owns a copy of the sieve (small primes and a tile) and takes the
+ * next unsieved strip from a shared counter until the octant is exhausted.
+ *
+ * A sieving prime whose norm exceeds the area of a tile has at most a few
+ * multiples in any one tile, so recomputing its bounds for every tile wastes
+ * most of the work. Such large primes are bucket sieved instead, in the manner
+ * of Oliveira e Silva: at the start of a strip each line of multiples is filed
+ * under the tile holding its lowest multiple, and when that tile comes up the
+ * line is run to the top of the tile and refiled under its next tile.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <numeric>
+#include "SegmentedDonutSieve.hpp"
+#include "SmallPrimes.hpp"
+#include "Threads.hpp"
+using namespace std;
+
+SegmentedDonutSieve::SegmentedDonutSieve(uint64_t x, bool verbose, uint32_t threads, uint32_t tileSize)
+    // The parent block starts as the tile at the origin. Tiles are never wider
+    // than the donut array itself.
+    : BlockDonutSieve(0, 0, 10 * min(tileSize, isqrt(x) / 10 + 1), 10 * min(tileSize, isqrt(x) / 10 + 1), verbose),
+      normBound(x),
+      tileSize(min(tileSize, isqrt(x) / 10 + 1)),
+      threads(threadCount(threads)),
+      firstLarge(0)
+{
+}
+
+// Sieving is deferred to getCountBigPrimes() and harvestBigPrimes(); here we only
+// need the small primes and the memory for a single tile.
+void SegmentedDonutSieve::run()
+{
+  setSmallPrimes();
+  setSieveArray();
+}
+
+// The maxNorm of the parent block is only that of the first tile, so small
+// primes are generated from the norm bound of the whole octant.
+void SegmentedDonutSieve::setSmallPrimes()
+{
+  if (verbose)
+  {
+    cerr << "Taking smallPrimes from the shared table..." << endl;
+  }
+  smallPrimes = SmallPrimes::upTo(isqrt(normBound)).toVector();
+  // smallPrimes are sorted by norm; the large ones are left to the buckets.
+  while ((firstLarge < smallPrimes.size()) && (smallPrimes[firstLarge].norm() <= uint64_t(dx) * dy))
+  {
+    firstLarge++;
+  }
+}
+
+// Index of the highest donut word in column a that holds a gint of the first
+// octant with norm at most normBound.
+uint32_t SegmentedDonutSieve::getTopWord(uint32_t a)
+{
+  return min(a, isqrt(normBound / 100 - uint64_t(a) * a));
+}
+
+// Number of donut words at the bottom of column a lying strictly below the
+// diagonal with every gint of norm at most normBound; these need no checks
+// when harvesting.
+uint32_t SegmentedDonutSieve::getInteriorWords(uint32_t a)
+{
+  uint64_t corner = 10 * uint64_t(a) + 9; // largest real part in column a
+  if (corner * corner + 81 > normBound)
+  {
+    return 0;
+  }
+  return min(a, (isqrt(normBound - corner * corner) - 9) / 10 + 1);
+}
+
+// Move the parent block so that its lower left word is the donut word (a, b),
+// and mark every entry of the tile surviving the pre-sieved primes as prime.
+void SegmentedDonutSieve::setTile(uint32_t a, uint32_t b)
+{
+  x = 10 * a;
+  y = 10 * b;
+  presieve();
+  if ((x == 0) && (y == 0))
+  {
+    setFalse(1, 0); // Crossing off 1
+    setFalse(0, 1); // Crossing off i
+  }
+}
+
+// Cross off multiples of the small primes within the current tile. Only primes
+// up to the square root of the largest norm of interest in the tile are needed;
+// primes beyond firstLarge are handled by crossOffBucket().
+void SegmentedDonutSieve::sieveTile()
+{
+  uint64_t u = x + dx - 1;
+  uint64_t v = y + dy - 1;
+  uint64_t bound = isqrt(min(normBound, u * u + v * v));
+  for (uint32_t i = 0; i < firstLarge; i++)
+  {
+    gint g = smallPrimes[i];
+    if (g.norm() > bound)
+    {
+      break; // smallPrimes are sorted by norm
+    }
+    crossOffMultiples(g);
+  }
+}
+
+// Set up the buckets for the strip of tiles whose lower left word is (a, 0)
+// and whose top tile holds the word (a, bMax). Every cofactor c + di in the
+// donut whose multiple by a large prime lands in the strip gives a line of
+// multiples moving up and to the left as d increases; the line is filed under
+// the tile holding its first multiple. Units are skipped so that the prime
+// itself is never crossed off.
+void SegmentedDonutSieve::fillBuckets(uint32_t a, uint32_t bMax)
+{
+  int64_t left = 10 * int64_t(a);
+  int64_t right = left + dx - 1;
+  int64_t top = int64_t(bMax / tileSize + 1) * dy - 1;
+  buckets.resize(bMax / tileSize + 1);
+  for (auto &bucket : buckets)
+  {
+    bucket.clear();
+  }
+  uint64_t bound = isqrt(min(normBound, uint64_t(right * right + top * top)));
+  for (uint32_t i = firstLarge; i < smallPrimes.size(); i++)
+  {
+    gint g = smallPrimes[i];
+    if (g.norm() > bound)
+    {
+      break; // smallPrimes are sorted by norm
+    }
+    int64_t pa = g.a;
+    int64_t pb = g.b;
+    int64_t N = g.norm();
+    // Need left <= ac - bd <= right and 0 <= bc + ad <= top.
+    for (int64_t c = (pa * left + N - 1) / N; c <= (pa * right + pb * top) / N; c++)
+    {
+      int64_t d, dUpper;
+      if (pb)
+      {
+        d = max(-floorDiv(right - pa * c, pb), -floorDiv(pb * c, pa));
+        dUpper = min(floorDiv(pa * c - left, pb), floorDiv(top - pb * c, pa));
+      }
+      else if (pa * c <= right)
+      {
+        d = 0;
+        dUpper = top / pa;
+      }
+      else
+      {
+        continue;
+      }
+      // Move d onto the donut, and then past the units 1 and i.
+      while (donut.gap[c % 10][mod(d, 10)] == 0)
+      {
+        d++;
+      }
+      if (c * c + d * d == 1)
+      {
+        d += donut.gap[c % 10][mod(d, 10)];
+      }
+      if (d <= dUpper)
+      {
+        buckets[(pb * c + pa * d) / dy].push_back({g.a, g.b, int32_t(c), int32_t(d)});
+      }
+    }
+  }
+}
+
+// Cross off the multiples of large primes within the current tile. Every line
+// in the bucket of this tile is followed until it leaves the tile, and is then
+// refiled under the next tile of the strip it meets, if any.
+void SegmentedDonutSieve::crossOffBucket(uint32_t t)
+{
+  vector<BucketEntry> bucket;
+  bucket.swap(buckets[t]);
+  int64_t top = int64_t(buckets.size()) * dy;
+  for (BucketEntry e : bucket)
+  {
+    int64_t u = int64_t(e.a) * e.c - int64_t(e.b) * e.d; // u = ac - bd
+    int64_t v = int64_t(e.b) * e.c + int64_t(e.a) * e.d; // v = bc + ad
+    while ((v < y + dy) && (u >= x))
+    {
+      setFalse(uint32_t(u - x), uint32_t(v - y));
+      int32_t jump = donut.gap[e.c % 10][mod(e.d, 10)];
+      e.d += jump;
+      u -= int64_t(jump) * e.b;
+      v += int64_t(jump) * e.a;
+      if ((e.c == 1) && (e.d == 0))
+      { // skipping over the unit 1
+        jump = donut.gap[1][0];
+        e.d += jump;
+        u -= int64_t(jump) * e.b;
+        v += int64_t(jump) * e.a;
+      }
+    }
+    if ((v < top) && (u >= x))
+    {
+      buckets[v / dy].push_back(e);
+    }
+  }
+  bucket.clear();
+  bucket.swap(buckets[t]); // keep the memory for the next strip
+}
+
+// Count the primes of the first octant within the current tile. If a sink is
+// given, also push them and their flipped associates onto it.
+uint64_t SegmentedDonutSieve::gatherTile(PrimeSink *sink)
+{
+  uint32_t realAxis = 0; // bits of the gints 10a + c with imaginary part 0
+  for (uint32_t bit = 0; bit < 32; bit++)
+  {
+    if (donut.imagPart[bit] == 0)
+    {
+      realAxis |= 1u << bit;
+    }
+  }
+  uint64_t count = 0;
+  uint32_t aMax = isqrt(normBound) / 10;
+  for (uint32_t i = 0; (i < tileSize) && (x / 10 + i <= aMax); i++)
+  {
+    uint32_t a = x / 10 + i;
+    uint32_t top = getTopWord(a);
+    uint32_t interior = getInteriorWords(a);
+    for (uint32_t j = 0; (j < tileSize) && (y / 10 + j <= top); j++)
+    {
+      uint32_t b = y / 10 + j;
+      uint32_t word = sieveArray[i][j];
+      if (!sink && (b < interior))
+      { // every prime not on the real axis is counted twice for its flip
+        count += 2 * __builtin_popcount(word) - (b ? 0 : __builtin_popcount(word & realAxis));
+        continue;
+      }
+      // Jump from one set bit to the next with ctz.
+      for (; word; word &= word - 1)
+      {
+        uint32_t bit = __builtin_ctz(word);
+        // Coordinates of actual gint.
+        uint64_t aa = 10 * a + donut.realPart[bit];
+        uint64_t bb = 10 * b + donut.imagPart[bit];
+        // check for boundary blocks and to avoid imag multiple of degree 2
+        if ((b < interior) || ((aa * aa + bb * bb <= normBound) && aa && (aa > bb)))
+        {
+          count++;
+          if (sink)
+          {
+            sink->push(gint(aa, bb));
+          }
+          if (bb)
+          { // prime not on real axis
+            count++;
+            if (sink)
+            {
+              sink->push(gint(bb, aa));
+            }
+          }
+        }
+      }
+    }
+  }
+  return count;
+}
+
+// Sieve strips of tiles, taking the index of the next unsieved strip from the
+// shared counter until every strip meeting the first octant has been taken.
+// Return the number of primes found in these strips.
+uint64_t SegmentedDonutSieve::sweepStrips(atomic<uint32_t> &nextStrip, PrimeSink *sink)
+{
+  uint64_t count = 0;
+  uint32_t aMax = isqrt(normBound) / 10;
+  uint32_t nStrips = aMax / tileSize + 1;
+  uint32_t barPos = 0;
+  for (uint32_t strip = nextStrip++; strip < nStrips; strip = nextStrip++)
+  {
+    uint32_t a = strip * tileSize;
+    // Highest donut word needed by any column in this vertical strip of tiles.
+    uint32_t bMax = 0;
+    for (uint32_t i = a; (i < a + tileSize) && (i <= aMax); i++)
+    {
+      bMax = max(bMax, getTopWord(i));
+    }
+    fillBuckets(a, bMax);
+    for (uint32_t b = 0; b <= bMax; b += tileSize)
+    {
+      setTile(a, b);
+      sieveTile();
+      crossOffBucket(b / tileSize);
+      count += gatherTile(sink);
+    }
+    if (verbose)
+    { // progress bar by strips of tiles handed out so far
+      for (; barPos < 80 * uint64_t(min(strip + 1, nStrips)) / nStrips; barPos++)
+      {
+        cerr << ".";
+      }
+    }
+  }
+  if (verbose)
+  {
+    for (; barPos < 80; barPos++)
+    {
+      cerr << ".";
+    }
+  }
+  return count;
+}
+
+// Hands the primes of one worker over to the shared sink a chunk at a time, so
+// that the lock is taken once per chunk rather than once per prime.
+class LockedSink : public PrimeSink
+{
+private:
+  PrimeSink &target;
+  mutex &lock;
+  void consume(const vector<gint> &primes) override
+  {
+    lock_guard<mutex> guard(lock);
+    for (gint g : primes)
+    {
+      target.push(g);
+    }
+  }
+
+public:
+  LockedSink(PrimeSink &target, mutex &lock) : target(target), lock(lock) {}
+};
+
+// Sieve every tile meeting the first octant and return the number of primes
+// found there, including the primes dividing 10 but not their associates.
+// Primes are pushed onto the sink if one is given, in no particular order.
+uint64_t SegmentedDonutSieve::sweep(PrimeSink *sink)
+{
+  if (verbose)
+  {
+    cerr << "Sieving the octant in tiles of " << tileSize << " x " << tileSize
+         << " donut words with " << threads << " thread(s)..." << endl;
+  }
+  auto startTime = chrono::high_resolution_clock::now();
+  uint64_t count = 3; // 3 primes dividing 10
+  if (sink)
+  {
+    sink->push(gint(1, 1));
+    sink->push(gint(2, 1));
+    sink->push(gint(1, 2));
+  }
+
+  atomic<uint32_t> nextStrip(0);
+  // Each helper thread works on its own copy of the sieve; this object is the
+  // first worker and the only one displaying progress.
+  vector<SegmentedDonutSieve> workers(threads - 1, *this);
+  for (SegmentedDonutSieve &worker : workers)
+  {
+    worker.verbose = false;
+  }
+  vector<uint64_t> counts(threads, 0);
+  // With a single thread the sink is fed directly; otherwise every worker
+  // fills its own chunks and forwards them under the lock.
+  mutex lock;
+  vector<LockedSink> sinks;
+  if (sink && (threads > 1))
+  {
+    sinks.reserve(threads);
+    for (uint32_t t = 0; t < threads; t++)
+    {
+      sinks.emplace_back(*sink, lock);
+    }
+  }
+  auto sinkOf = [&](uint32_t t) -> PrimeSink * { return sinks.empty() ? sink : &sinks[t]; };
+  onThreads(threads, [&](uint32_t t) { counts[t] = (t ? workers[t - 1] : *this).sweepStrips(nextStrip, sinkOf(t)); });
+  count += accumulate(counts.begin(), counts.end(), uint64_t(0));
+  for (LockedSink &s : sinks)
+  {
+    s.flush();
+  }
+
+  auto endTime = chrono::high_resolution_clock::now();
+  auto totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+  double printTime = double(totalTime.count()) / 1000.0;
+  if (verbose)
+  {
+    cerr << "\nDone sieving. Total time for sieving: " << printTime << " seconds." << endl;
+  }
+  return count;
+}
+
+void SegmentedDonutSieve::harvestBigPrimes(PrimeSink &sink)
+{
+  if (verbose)
+  {
+    cerr << "Gathering primes while sieving..." << endl;
+  }
+  sweep(&sink);
+  if (verbose)
+  {
+    cerr << "Done gathering." << endl;
+  }
+}
+
+uint64_t SegmentedDonutSieve::getCountBigPrimes()
+{
+  if (verbose)
+  {
+    cerr << "Counting primes while sieving..." << endl;
+  }
+  uint64_t count = 4 * sweep(nullptr); // four quadrants
+  if (verbose)
+  {
+    cerr << "Total number of primes, including associates: " << count << "\n"
+         << endl;
+  }
+  return count;
+}
@@ -30,15 +30,12 @@
 
 #include <iostream>
 #include "Moat.hpp"
-#include "OctantDonutSieve.hpp"
 
 // Need to first declare static member variables here in the cpp source.
 bool SegmentedMoat::verbose;
 double SegmentedMoat::jumpSize;
 uint32_t SegmentedMoat::previousdy;
 uint64_t SegmentedMoat::blockSize;
-uint64_t SegmentedMoat::sievingPrimesNormBound;
-vector<gint> SegmentedMoat::sievingPrimes;
 vector<gint> SegmentedMoat::nearestNeighbors;
 vector<vector<gint>> SegmentedMoat::leftBoundary;
 vector<uint64_t> SegmentedMoat::componentSizes;
@@ -87,10 +84,6 @@ void SegmentedMoat::setStatics(double js, bool vb)
     blockSize = pow(10, 9);
   }
 
-  // Bound on the norm of pre-computed primes. Arbitrary initial value.
-  sievingPrimesNormBound = uint64_t(pow(10, 4));
-  setSievingPrimes();
-
   // Setting nearest neighbors.
   for (int32_t u = -int32_t(jumpSize); u < jumpSize; u++)
   {
@@ -136,17 +129,6 @@ void SegmentedMoat::setStatics(double js, bool vb)
   leftBoundary.push_back(component);
 }
 
-void SegmentedMoat::setSievingPrimes()
-{
-  if (verbose)
-  {
-    cerr << "Precomputing sieving primes." << endl;
-  }
-  OctantDonutSieve d(sievingPrimesNormBound, false); // verbose = false
-  d.run();
-  sievingPrimes = d.getBigPrimes();
-}
-
 SegmentedMoat::SegmentedMoat(uint32_t x, uint32_t dx, uint32_t dy)
     // Calling BlockSieve's constructor
     : BlockSieve(x, 0, dx, dy, false) // not letting this be verbose
@@ -188,24 +170,7 @@ SegmentedMoat::SegmentedMoat(uint32_t x, uint32_t dx, uint32_t dy)
 // Cannot call virtual methods of BlockSieve parent from BlockMoat constructor.
 void SegmentedMoat::callSieve()
 {
-  // Checking to make sure there are enough primes within sievingPrimes
-  gint last_g = sievingPrimes.back();
-  while (last_g.norm() < isqrt(maxNorm))
-  {
-    sievingPrimesNormBound *= 2;
-    setSievingPrimes();
-    last_g = sievingPrimes.back();
-  }
-
-  vector<gint> smallPrimes;
-  for (gint g : sievingPrimes)
-  {
-    if (g.norm() <= maxNorm)
-    {
-      smallPrimes.push_back(g);
-    }
-  }
-  setSmallPrimesFromReference(smallPrimes);
+  setSmallPrimes(); // from the shared table, which grows as needed
   setSieveArray();
   sieve();
 }
@@ -229,7 +194,7 @@ void SegmentedMoat::exploreComponent(uint32_t startingIndex, bool startingFromLe
   // Indicating with sieveArray that these gints have been visited
   for (gint g : toExplore)
   {
-    sieveArray[g.a][g.b] = false;
+    sieveArray.reset(g.a, g.b);
   }
 
   do
@@ -257,7 +222,7 @@ void SegmentedMoat::exploreComponent(uint32_t startingIndex, bool startingFromLe
         {
           leftComponentLookUp[g.a][g.b] = startingIndex;
           toExplore.push_back(g);
-          sieveArray[g.a][g.b] = false;
+          sieveArray.reset(g.a, g.b);
         }
       }
     }
@@ -275,10 +240,10 @@ void SegmentedMoat::exploreComponent(uint32_t startingIndex, bool startingFromLe
     for (const gint &q : nearestNeighbors)
     {
       gint h = p + q;
-      if (h.a >= 0 && h.a < dx && h.b >= 0 && h.b < dy && h.b <= x + h.a && sieveArray[h.a][h.b])
+      if (h.a >= 0 && h.a < dx && h.b >= 0 && h.b < dy && h.b <= x + h.a && sieveArray.test(h.a, h.b))
       {
         toExplore.push_back(h);
-        sieveArray[h.a][h.b] = false; // indicating a visit here so we don't push back h again
+        sieveArray.reset(h.a, h.b); // indicating a visit here so we don't push back h again
       }
     }
   } while (!toExplore.empty());
@@ -315,7 +280,7 @@ void SegmentedMoat::exploreRightBoundary()
     for (uint32_t b = 0; b < dy; b++)
     {
       // Checking if unvisited, prime, and within first octant.
-      if (sieveArray[a][b] && b < a + x)
+      if (sieveArray.test(a, b) && b < a + x)
       {
         // Finding an available index, or pushing new one.
         uint32_t index = 1;
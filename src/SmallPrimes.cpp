@@ -0,0 +1,246 @@
+/* The table of small primes shared by every sieve. Sieves of many blocks,
+ * sectors or annuli in one process, as in the Python module or the moat
+ * searches, would otherwise each run an OctantSieve up to the square root of
+ * their norm bound.
+ *
+ * To reach a norm x beyond the current bound B, the table is extended to
+ * max(x, 2B) so that a slowly growing bound is met with few extensions. If the
+ * table already holds the primes up to the square root of the new bound, only
+ * the annulus B < norm <= x is sieved, by AnnulusSieve, and its primes sorted
+ * by norm are appended; otherwise the table is rebuilt by an OctantSieve. A new
+ * table is built beside the old one, without holding the lock, and swapped in,
+ * so views handed out before are never touched.
+ *
+ * The cache file holds a CacheHeader followed by the table as pairs of 32-bit
+ * integers a, b. Before sieving, a cache reaching further than the table is
+ * mapped in place of it; after sieving, the table is written to a temporary
+ * file which is then renamed over the cache, so that other processes reading
+ * the cache only ever see a whole file. A cache which cannot be read or
+ * written is passed over, and the primes are sieved as if there were none.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "SmallPrimes.hpp"
+#include "OctantSieve.hpp"
+#include "AnnulusSieve.hpp"
+using namespace std;
+
+static_assert(sizeof(gint) == 2 * sizeof(int32_t), "gints are stored as two int32_t");
+
+struct CacheHeader
+{
+  char magic[8];       // "GINTPRM"
+  uint32_t version;    // layout of the file
+  uint32_t gintSize;   // bytes per prime
+  uint64_t bound;      // every prime of norm at most bound is listed
+  uint64_t count;      // number of primes listed
+};
+
+static const char cacheMagic[8] = "GINTPRM";
+static const uint32_t cacheVersion = 1;
+
+// Index just past the primes of norm at most x in a table sorted by norm.
+static size_t countUpTo(const gint *table, size_t size, uint64_t x)
+{
+  return upper_bound(table, table + size, x, [](uint64_t x, gint g) {
+           return x < g.norm();
+         }) -
+         table;
+}
+
+static bool mapCache(const string &, uint64_t, shared_ptr<const gint> &, size_t &, uint64_t &);
+static void writeTable(const string &, const gint *, size_t, uint64_t);
+
+mutex SmallPrimes::tableMutex;
+condition_variable SmallPrimes::tableGrown;
+bool SmallPrimes::extending = false;
+shared_ptr<const gint> SmallPrimes::table;
+size_t SmallPrimes::tableSize = 0;
+uint64_t SmallPrimes::bound = 0;
+string SmallPrimes::cacheFile = getenv("GINT_PRIMES_CACHE") ? getenv("GINT_PRIMES_CACHE") : "";
+
+// Views of the table are taken under tableMutex, but the table is extended
+// outside of it: a thread asking for primes already in the table never waits
+// for an extension it does not need. One thread extends at a time, and those
+// needing more wait for it to finish before trying again.
+SmallPrimes::View SmallPrimes::upTo(uint64_t x)
+{
+  unique_lock<mutex> guard(tableMutex);
+  while ((x > bound) && !(loadCache() && (x <= bound)))
+  {
+    if (extending)
+    {
+      tableGrown.wait(guard);
+      continue;
+    }
+    extending = true;
+    View old(table, tableSize);
+    uint64_t oldBound = bound;
+    uint64_t newBound = max(x, 2 * bound);
+    string path = cacheFile;
+    guard.unlock();
+    shared_ptr<vector<gint>> grown;
+    try
+    {
+      grown = extend(old, oldBound, newBound);
+    }
+    catch (...)
+    {
+      guard.lock();
+      extending = false;
+      tableGrown.notify_all();
+      throw;
+    }
+    // The new table shares ownership of the vector holding it.
+    shared_ptr<const gint> newTable(grown, grown->data());
+    writeTable(path, newTable.get(), grown->size(), newBound);
+    guard.lock();
+    if (newBound > bound) // unless a larger cache was mapped meanwhile
+    {
+      table = newTable;
+      tableSize = grown->size();
+      bound = newBound;
+    }
+    extending = false;
+    tableGrown.notify_all();
+  }
+  return View(table, countUpTo(table.get(), tableSize, x));
+}
+
+uint64_t SmallPrimes::getBound()
+{
+  lock_guard<mutex> guard(tableMutex);
+  return bound;
+}
+
+void SmallPrimes::setCacheFile(const string &path)
+{
+  lock_guard<mutex> guard(tableMutex);
+  cacheFile = path;
+}
+
+// The table up to newBound, from the old table holding every prime of norm at
+// most oldBound. Called without tableMutex; the old table is never changed.
+shared_ptr<vector<gint>> SmallPrimes::extend(const View &old, uint64_t oldBound, uint64_t newBound)
+{
+  uint32_t sievingBound = isqrt(newBound);
+  shared_ptr<vector<gint>> grown;
+  if (sievingBound > oldBound)
+  {
+    OctantSieve s(newBound, false);
+    s.run();
+    grown = make_shared<vector<gint>>(s.getBigPrimes());
+  }
+  else
+  {
+    AnnulusSieve s(oldBound + 1, newBound, false);
+    s.setSmallPrimesFromReference(vector<gint>(old.begin(), old.begin() + countUpTo(old.begin(), old.size(), sievingBound)));
+    s.setSieveArray();
+    s.sieve();
+    vector<gint> annulus = s.getBigPrimes(true, true); // radix sort
+    grown = make_shared<vector<gint>>();
+    grown->reserve(old.size() + annulus.size());
+    grown->insert(grown->end(), old.begin(), old.end());
+    grown->insert(grown->end(), annulus.begin(), annulus.end());
+  }
+  return grown;
+}
+
+// Map the cache file at path if it is valid and lists every prime of norm at
+// most minBound, setting table, size and bound to what it holds.
+static bool mapCache(const string &path, uint64_t minBound, shared_ptr<const gint> &table, size_t &size, uint64_t &bound)
+{
+  if (path.empty())
+  {
+    return false;
+  }
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    return false;
+  }
+  struct stat info;
+  CacheHeader header;
+  bool valid = (fstat(fd, &info) == 0) && (uint64_t(info.st_size) >= sizeof(header)) &&
+               (pread(fd, &header, sizeof(header), 0) == sizeof(header)) &&
+               (memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) == 0) &&
+               (header.version == cacheVersion) && (header.gintSize == sizeof(gint)) &&
+               (uint64_t(info.st_size) == sizeof(header) + header.count * sizeof(gint)) &&
+               (header.bound >= minBound);
+  if (!valid)
+  {
+    close(fd);
+    return false;
+  }
+  size_t length = info.st_size;
+  void *map = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); // the mapping outlives the descriptor
+  if (map == MAP_FAILED)
+  {
+    return false;
+  }
+  const gint *first = reinterpret_cast<const gint *>(static_cast<const char *>(map) + sizeof(header));
+  table = shared_ptr<const gint>(first, [map, length](const gint *) { munmap(map, length); });
+  size = header.count;
+  bound = header.bound;
+  return true;
+}
+
+// Write the size primes of table, every one of norm at most bound, to the
+// cache file at path by way of a temporary file.
+static void writeTable(const string &path, const gint *table, size_t size, uint64_t bound)
+{
+  if (path.empty())
+  {
+    return;
+  }
+  CacheHeader header;
+  memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+  header.version = cacheVersion;
+  header.gintSize = sizeof(gint);
+  header.bound = bound;
+  header.count = size;
+  string temporary = path + ".tmp" + to_string(getpid());
+  FILE *f = fopen(temporary.c_str(), "wb");
+  if (!f)
+  {
+    return;
+  }
+  bool written = (fwrite(&header, sizeof(header), 1, f) == 1) &&
+                 (fwrite(table, sizeof(gint), size, f) == size);
+  written = (fclose(f) == 0) && written;
+  if (!written || (rename(temporary.c_str(), path.c_str()) != 0))
+  {
+    remove(temporary.c_str());
+  }
+}
+
+// Map the cache in place of the table if it reaches further. Called with
+// tableMutex held; returns whether the table was replaced.
+bool SmallPrimes::loadCache()
+{
+  return mapCache(cacheFile, bound + 1, table, tableSize, bound);
+}
+
+// The file at path is only read or written here, and the shared table is
+// used as it would be without it.
+SmallPrimes::View SmallPrimes::fromFile(const string &path, uint64_t x)
+{
+  shared_ptr<const gint> mapped;
+  size_t size;
+  uint64_t mappedBound;
+  if (mapCache(path, x, mapped, size, mappedBound))
+  {
+    return View(mapped, countUpTo(mapped.get(), size, x));
+  }
+  View primes = upTo(x);
+  writeTable(path, primes.begin(), primes.size(), x);
+  return primes;
+}
@@ -21,7 +21,7 @@
 
 #include <iostream>
 #include "Moat.hpp"
-#include "OctantDonutSieve.hpp"
+#include "SmallPrimes.hpp"
 
 // Need to first declare static member variables here in source.
 bool VerticalMoat::verbose;
@@ -31,7 +31,6 @@ int32_t VerticalMoat::blockSize;
 int32_t VerticalMoat::dx;
 int32_t VerticalMoat::dy;
 uint64_t VerticalMoat::sievingPrimesNormBound;
-vector<gint> VerticalMoat::sievingPrimes;
 vector<gint> VerticalMoat::nearestNeighbors;
 
 // Call this static setter method before any instances of this class are created.
@@ -71,9 +70,7 @@ void VerticalMoat::setStatics(uint32_t rp, double js, bool vb)
   {
     cerr << "Precomputing sieving primes." << endl;
   }
-  OctantDonutSieve d(sievingPrimesNormBound, false); // not letting this be verbose
-  d.run();
-  sievingPrimes = d.getBigPrimes();
+  SmallPrimes::upTo(sievingPrimesNormBound); // filling the shared table
 }
 
 // Constructor
@@ -96,23 +93,7 @@ VerticalMoat::VerticalMoat(uint32_t x, uint32_t y)
 // Cannot call virtual methods of parent class BlockSieve from within VerticalMoat constructor.
 void VerticalMoat::callSieve()
 {
-  // Checking to make sure there are enough primes within sievingPrimes
-  gint last_g = sievingPrimes.back();
-  if (last_g.norm() < isqrt(maxNorm))
-  {
-    cerr << "Not enough pre-computed primes in static variable sievingPrimes..." << endl;
-    exit(1);
-  }
-
-  vector<gint> smallPrimes;
-  for (gint g : sievingPrimes)
-  {
-    if (g.norm() <= maxNorm)
-    {
-      smallPrimes.push_back(g);
-    }
-  }
-  setSmallPrimesFromReference(smallPrimes);
+  setSmallPrimes(); // from the shared table, which grows as needed
   setSieveArray();
   sieve();
 }
@@ -131,7 +112,7 @@ bool VerticalMoat::exploreAtGint(int32_t a, int32_t b, bool upperWallFlag)
   {
     gint p = toExplore.back();
     toExplore.pop_back();
-    sieveArray[p.a][p.b] = false; // indicating a visit
+    sieveArray.reset(p.a, p.b); // indicating a visit
     countVisited++;
     for (const gint &q : nearestNeighbors)
     {
@@ -173,7 +154,7 @@ bool VerticalMoat::exploreAtGint(int32_t a, int32_t b, bool upperWallFlag)
 
       // If we are not interacting with the boundary, keep exploring. The
       // check g.a < dx is somewhat redundant.
-      if (g.a >= 0 && g.a < dx && g.b >= 0 && g.b < dy && sieveArray[g.a][g.b])
+      if (g.a >= 0 && g.a < dx && g.b >= 0 && g.b < dy && sieveArray.test(g.a, g.b))
       {
         toExplore.push_back(g);
         if ((!upperWallFlag) && (g.a > farthestRight))
@@ -192,7 +173,7 @@ bool VerticalMoat::exploreLeftWall()
   {
     for (int32_t b = 0; b < dy; b++)
     {
-      if (sieveArray[a][b])
+      if (sieveArray.test(a, b))
       {
         // Check if we've punched through block.
         if (exploreAtGint(a, b))
@@ -212,7 +193,7 @@ void VerticalMoat::exploreUpperWall()
   {
     for (int32_t a = 0; a < dx; a++)
     {
-      if (sieveArray[a][b])
+      if (sieveArray.test(a, b))
       {
         exploreAtGint(a, b, true);
       }
@@ -2,34 +2,56 @@
 
 #include "cython_bindings.hpp"
 #include "OctantDonutSieve.hpp"
-#include "SectorSieve.hpp"
+#include "AngularHistogram.hpp"
+#include "SectorDonutSieve.hpp"
+#include "SectorRaces.hpp"
+#include "SegmentedDonutSieve.hpp"
+#include "BlockBatch.hpp"
+#include "SmallPrimes.hpp"
+#include "PrimeCounting.hpp"
+#include "NormSort.hpp"
 #include "Moat.hpp"
 #include <iostream>
 #include <cmath>
 #include <numeric>
+#include <stdexcept>
 
-// Creating a 1-dimensional arrays to hold big primes; this way we can avoid
-// an array of pointers which might be needed for 2d array. This will be fed
-// into a memory view object a la cython to give numpy access. The keyword
-// "new" will prevent the array from decaying into garbage.
-// This function is called in various functions below.
-// In the cython file gintsieve.pyx, there is an inverse function to this one.
-pair<int32_t *, uint64_t> gintVectorToArray(vector<gint> v)
+// Handing primes over to numpy without copying them. A gint is two int32_t,
+// so the data of the vector is already the (n, 2) array numpy needs; the vector
+// is moved onto the heap, and is deleted by freeGintArray when numpy drops the
+// array holding it. In the cython file gaussianprimes.pyx, gint_array_to_np
+// builds this array.
+GintArray gintVectorToArray(vector<gint> v)
 {
-  // Creating a 1-dimensional array to hold big primes; this way we can avoid
-  // an array of pointers which might be needed for 2d array.
-  uint64_t size = v.size();
-  auto *a = new int32_t[2 * size]; // declaring the array
-  for (uint64_t i = 0; i < size; i++)
-  {
-    a[2 * i] = v[i].a;
-    a[2 * i + 1] = v[i].b;
-  }
-  return pair<int32_t *, uint64_t>{a, 2 * size};
+  static_assert(sizeof(gint) == 2 * sizeof(int32_t), "gints are read by numpy as two int32_t");
+  auto *owner = new vector<gint>(move(v));
+  return GintArray{reinterpret_cast<int32_t *>(owner->data()), owner->size(), owner};
+}
+
+void freeGintArray(void *owner)
+{
+  delete static_cast<vector<gint> *>(owner);
+}
+
+// Gathering the primes of a sieve after run() into a vector reserved with room
+// for the expected number of primes, so that it is not reallocated on the way,
+// and radix sorting them in place. The expected number must be cheap to find:
+// sieves which only sieve while harvesting, as SegmentedDonutSieve does, would
+// sieve everything twice if counted first, so an estimate is passed for them.
+template <typename S>
+static vector<gint> getSortedPrimes(S &s, uint64_t expected)
+{
+  vector<gint> primes;
+  primes.reserve(expected);
+  s.visitBigPrimes([&](const vector<gint> &chunk) {
+    primes.insert(primes.end(), chunk.begin(), chunk.end());
+  });
+  radixSortByNorm(primes);
+  return primes;
 }
 
 // Counting Gaussian primes and associates upto a given norm.
-uint64_t gPrimesToNormCount(uint64_t x)
+uint64_t gPrimesToNormCount(uint64_t x, uint32_t threads)
 {
   if (x < 2)
   {
@@ -43,18 +65,31 @@ uint64_t gPrimesToNormCount(uint64_t x)
   {
     // Show display if passed argument is large.
     bool verbose = x >= (uint64_t)pow(10, 9);
+    if (threads != 1)
+    {
+      SegmentedDonutSieve s(x, verbose, threads);
+      s.run();
+      return s.getCountBigPrimes();
+    }
     OctantDonutSieve s(x, verbose);
     s.run();
     return s.getCountBigPrimes();
   }
 }
 
+// Counting Gaussian primes and associates upto a given norm by counting rational
+// primes in residue classes mod 4.
+uint64_t gPrimesToNormCountRational(uint64_t x)
+{
+  return countGPrimesToNorm(x);
+}
+
 // Counting Gaussian primes in sector upto a given norm.
-uint64_t gPrimesInSectorCount(uint64_t x, double alpha, double beta)
+uint64_t gPrimesInSectorCount(uint64_t x, double alpha, double beta, uint32_t threads)
 {
   // Show display if passed argument is large.
   bool verbose = x >= (uint64_t)pow(10, 9);
-  SectorSieve s(x, alpha, beta, verbose);
+  SectorDonutSieve s(x, alpha, beta, verbose, threads);
   s.run();
   return s.getCountBigPrimes();
 }
@@ -69,40 +104,78 @@ uint64_t gPrimesInBlockCount(uint32_t x, uint32_t y, uint32_t dx, uint32_t dy)
   return s.getCountBigPrimes();
 }
 
-// Getting Gaussian primes upto a given norm. Passing a pointer to an array in
-// c++, so data is not explicitly copied between memory controlled by c++ and
-// python.
-pair<int32_t *, uint64_t> gPrimesToNormAsArray(uint64_t x)
+// Unpacking blocks passed from python as lists [x, y, dx, dy].
+static vector<array<uint32_t, 4>> toBlocks(const vector<vector<uint32_t>> &v)
+{
+  vector<array<uint32_t, 4>> blocks;
+  blocks.reserve(v.size());
+  for (const vector<uint32_t> &block : v)
+  {
+    if (block.size() != 4)
+    {
+      throw invalid_argument("Each block must be given as x, y, dx, dy.");
+    }
+    blocks.push_back({block[0], block[1], block[2], block[3]});
+  }
+  return blocks;
+}
+
+// Counting primes in many blocks; the small primes are found only once.
+vector<uint64_t> gPrimesInBlocksCount(const vector<vector<uint32_t>> &v, uint32_t threads)
+{
+  BlockBatch b(toBlocks(v), false, threads);
+  return b.getCounts();
+}
+
+// Getting Gaussian primes upto a given norm. The primes are gathered straight
+// into the buffer which numpy takes over, so they are never copied between
+// memory controlled by c++ and python.
+GintArray gPrimesToNormAsArray(uint64_t x, uint32_t threads)
 {
   vector<gint> gintP;
   if (x >= 5)
   {
     // Show display if passed argument is large.
     bool verbose = x >= (uint64_t)pow(10, 9);
-    OctantDonutSieve s(x, verbose);
-    s.run();
-    gintP = s.getBigPrimes();
+    if (threads != 1)
+    {
+      SegmentedDonutSieve s(x, verbose, threads);
+      s.run();
+      // Its tiles are only sieved while harvesting, so rather than counting,
+      // reserve for x / (log x - 1.1) primes, one of four associates each;
+      // this is at least the true number at each power of ten up to 10^9.
+      gintP = getSortedPrimes(s, uint64_t(x / (log(double(x)) - 1.1)));
+    }
+    else
+    {
+      OctantDonutSieve s(x, verbose);
+      s.run();
+      gintP = getSortedPrimes(s, s.getCountBigPrimes() / 4);
+    }
   }
   else if (x >= 2)
   {
     gintP.emplace_back(1, 1);
   }
-  return gintVectorToArray(gintP);
+  return gintVectorToArray(move(gintP));
 }
 
-// Getting Gaussian primes in sector upto given norm. Return pointer to an array.
-pair<int32_t *, uint64_t> gPrimesInSectorAsArray(uint64_t x, double alpha, double beta)
+// Getting Gaussian primes in sector upto given norm, as an array for numpy.
+GintArray gPrimesInSectorAsArray(
+    uint64_t x,
+    double alpha,
+    double beta,
+    uint32_t threads)
 {
   // Show display if passed argument is large.
   bool verbose = x >= (uint64_t)pow(10, 9);
-  SectorSieve s(x, alpha, beta, verbose);
+  SectorDonutSieve s(x, alpha, beta, verbose, threads);
   s.run();
-  vector<gint> gintP = s.getBigPrimes();
-  return gintVectorToArray(gintP);
+  return gintVectorToArray(getSortedPrimes(s, s.getCountBigPrimes()));
 }
 
-// Getting Gaussian primes in block. Return pointer to an array.
-pair<int32_t *, uint64_t> gPrimesInBlockAsArray(
+// Getting Gaussian primes in block, as an array for numpy.
+GintArray gPrimesInBlockAsArray(
     uint32_t x,
     uint32_t y,
     uint32_t dx,
@@ -112,32 +185,76 @@ pair<int32_t *, uint64_t> gPrimesInBlockAsArray(
   bool verbose = dx * dy >= (uint64_t)pow(10, 9);
   BlockSieve s(x, y, dx, dy, verbose);
   s.run();
-  vector<gint> gintP = s.getBigPrimes();
-  return gintVectorToArray(gintP);
+  return gintVectorToArray(getSortedPrimes(s, s.getCountBigPrimes()));
 }
 
-// Getting statistics on the angular distribution of Gaussian primes to norm.
-vector<uint64_t> angularDistribution(uint64_t x, uint32_t nSectors)
+// Primes of many blocks, passed to numpy one array per block.
+vector<GintArray> gPrimesInBlocksAsArrays(
+    const vector<vector<uint32_t>> &v,
+    uint32_t threads)
 {
-  // A vector holding nSectors, each with value 0.
-  vector<uint64_t> sectors(nSectors, 0);
-  OctantDonutSieve s(x);
-  s.run();
-  vector<gint> gintP = s.getBigPrimes(false); // not sorting
-  cerr << "Putting primes into bins according to their angle...." << endl;
-  for (gint g : gintP)
+  BlockBatch b(toBlocks(v), false, threads);
+  vector<vector<gint>> primes = b.getBigPrimes(true, true); // radix sort
+  vector<GintArray> toReturn;
+  toReturn.reserve(primes.size());
+  for (vector<gint> &blockPrimes : primes)
   {
-    double angle = g.arg();
-    auto sector = uint32_t(nSectors * angle / M_PI_4);
-    // Only considering first octant (not second).
-    // Inert primes cause outliers in first sector count;
-    // perhaps should count with multiplicity 1/2.
-    if (sector < nSectors)
+    toReturn.push_back(gintVectorToArray(move(blockPrimes)));
+  }
+  return toReturn;
+}
+
+// Passing the next prime in norm order back as a pair, which cython turns into
+// a tuple.
+pair<int32_t, int32_t> nextGPrimeByNorm(NormOrderedPrimes &primes)
+{
+  return primes.next().asPair();
+}
+
+// The whole octant is covered one tile at a time by a single-threaded
+// SegmentedDonutSieve, so that the memory of the stream does not grow with x.
+PrimeStream *streamGPrimesToNorm(uint64_t x, uint64_t chunkSize)
+{
+  return new PrimeStream([x](PrimeSink &sink) {
+    if (x >= 5)
     {
-      sectors[sector]++;
+      SegmentedDonutSieve s(x, false, 1);
+      s.run();
+      s.harvestBigPrimes(sink);
     }
-  }
-  return sectors;
+    else if (x >= 2)
+    {
+      sink.push(gint(1, 1));
+    }
+  }, chunkSize);
+}
+
+PrimeStream *streamGPrimesInBlock(uint32_t x, uint32_t y, uint32_t dx, uint32_t dy, uint64_t chunkSize)
+{
+  return new PrimeStream([=](PrimeSink &sink) {
+    BlockSieve s(x, y, dx, dy, false);
+    s.run();
+    s.harvestBigPrimes(sink);
+  }, chunkSize);
+}
+
+GintArray nextGPrimeChunk(PrimeStream &stream)
+{
+  return gintVectorToArray(stream.next());
+}
+
+void setPrimesCache(const string &path)
+{
+  SmallPrimes::setCacheFile(path);
+}
+
+// Getting statistics on the angular distribution of Gaussian primes with
+// x1 <= norm <= x2. The primes are binned by AngularHistogram as each annulus
+// is harvested, and never gathered.
+vector<uint64_t> angularDistribution(uint64_t x1, uint64_t x2, uint32_t nSectors, uint32_t threads)
+{
+  AngularHistogram h(x1, x2, nSectors, true, threads);
+  return h.getCounts();
 }
 
 // Public methods in SectorRace class.
@@ -147,66 +264,67 @@ SectorRace::SectorRace(
     long double alpha,
     long double beta,
     long double gamma,
-    long double delta)
-    // initializer list
-    : x(x), nBins(nBins)
+    long double delta,
+    uint32_t threads,
+    bool keepPrimes)
 {
   cerr << "Running Sector Sieves...\n"
        << endl;
-  SectorSieve s1(x, alpha, beta);
-  SectorSieve s2(x, gamma, delta);
-  s1.run();
-  s2.run();
-  // Not sorting big primes.
-  firstSector = s1.getBigPrimes(false);
-  secondSector = s2.getBigPrimes(false);
-  setNormData();
+  // Both sectors are sieved in one pass, tallied as their primes are found.
+  SectorRaces r(x, nBins, {{alpha, beta, gamma, delta}}, keepPrimes, true, threads);
+  r.run();
+  normData = r.getNormData(0);
+  if (keepPrimes)
+  {
+    // Not sorting big primes.
+    firstSector = r.takeSectorPrimes(0);
+    secondSector = r.takeSectorPrimes(1);
+  }
 }
 
-void SectorRace::setNormData()
+// The primes of each sector are handed over, not copied; empty unless kept.
+GintArray SectorRace::getFirstSector()
 {
-  cerr << "Collecting norm data for sector race..." << endl;
-  // Collecting norm data by creating an vector of all 0s with length nBins
-  for (uint64_t i = 0; i < nBins; i++)
-  {
-    normData.push_back(0);
-  }
-  // Incrementing for gints in first sector; decrementing for gints in second sector.
-  for (gint g : firstSector)
-  {
-    normData[g.norm() * nBins / x]++;
-  }
-  for (gint g : secondSector)
-  {
-    normData[g.norm() * nBins / x]--;
-  }
-  // Taking cumulative sum and overwriting normData with it.
-  partial_sum(normData.begin(), normData.end(), normData.begin());
+  return gintVectorToArray(move(firstSector));
 }
 
-pair<int32_t *, uint64_t> SectorRace::getFirstSector()
+GintArray SectorRace::getSecondSector()
 {
-  return gintVectorToArray(firstSector);
+  return gintVectorToArray(move(secondSector));
 }
 
-pair<int32_t *, uint64_t> SectorRace::getSecondSector()
+vector<int64_t> SectorRace::getNormData()
 {
-  return gintVectorToArray(secondSector);
+  return normData;
 }
 
-// Putting normData contents into an array; see comment above on memory view.
-int32_t *SectorRace::getNormData()
+vector<vector<int64_t>> sectorRacesNormData(
+    uint64_t x,
+    uint64_t nBins,
+    const vector<vector<long double>> &races,
+    uint32_t threads)
 {
-  auto *data = new int32_t[nBins]; // declaring the array
-  for (uint32_t i = 0; i < nBins; i++)
+  vector<array<long double, 4>> angles;
+  for (const vector<long double> &race : races)
+  {
+    if (race.size() != 4)
+    {
+      throw invalid_argument("Each race should be given by four angles alpha, beta, gamma, delta.");
+    }
+    angles.push_back({race[0], race[1], race[2], race[3]});
+  }
+  SectorRaces r(x, nBins, angles, false, true, threads);
+  r.run();
+  vector<vector<int64_t>> toReturn;
+  for (uint32_t k = 0; k < races.size(); k++)
   {
-    data[i] = normData[i];
+    toReturn.push_back(r.getNormData(k));
   }
-  return data;
+  return toReturn;
 }
 
 // Wrapper functions to access moat data
-pair<int32_t *, uint64_t> moatMainComponent(double jumpSize)
+GintArray moatMainComponent(double jumpSize)
 {
   OctantMoat m(jumpSize);
   m.exploreComponent(0, 0);
@@ -214,24 +332,24 @@ pair<int32_t *, uint64_t> moatMainComponent(double jumpSize)
   // pushing gint with max norm onto end of vector
   gint g = m.getComponentMaxElement();
   component.push_back(g);
-  return gintVectorToArray(component);
+  return gintVectorToArray(move(component));
 }
 
-vector<pair<int32_t *, uint64_t>> moatComponentsToNorm(double jumpSize, uint64_t x)
+vector<GintArray> moatComponentsToNorm(double jumpSize, uint64_t x)
 {
   OctantMoat m(jumpSize, x);
   m.exploreAllComponents();
   vector<vector<gint>> allComponents = m.getAllComponents();
-  vector<pair<int32_t *, uint64_t>> toReturn;
+  vector<GintArray> toReturn;
   toReturn.reserve(allComponents.size()); // pre-allocating size
-  for (const vector<gint> &v : allComponents)
+  for (vector<gint> &v : allComponents)
   {
-    toReturn.push_back(gintVectorToArray(v));
+    toReturn.push_back(gintVectorToArray(move(v)));
   }
   return toReturn;
 }
 
-vector<pair<int32_t *, uint64_t>> moatComponentsInBlock(
+vector<GintArray> moatComponentsInBlock(
     double jumpSize,
     uint32_t x,
     uint32_t y,
@@ -247,11 +365,11 @@ vector<pair<int32_t *, uint64_t>> moatComponentsInBlock(
   // putting edges in allComponents while we pass data to python
   allComponents.push_back(edges);
 
-  vector<pair<int32_t *, uint64_t>> toReturn;
+  vector<GintArray> toReturn;
   toReturn.reserve(allComponents.size()); // pre-allocating size
-  for (const vector<gint> &v : allComponents)
+  for (vector<gint> &v : allComponents)
   {
-    toReturn.push_back(gintVectorToArray(v));
+    toReturn.push_back(gintVectorToArray(move(v)));
   }
   return toReturn;
 }
@@ -295,13 +413,13 @@ void BlockMoat::exploreComponent(gint g0)
   {
     gint p = toExplore.back();
     toExplore.pop_back();
-    sieveArray[p.a][p.b] = false; // indicating a visit
+    sieveArray.reset(p.a, p.b); // indicating a visit
     for (const gint &q : nearestNeighbors)
     {
       gint g = p + q;
 
       // Pushing neighbors onto the vector toExplore
-      if (g.a >= 0 && g.a < int32_t(dx) && g.b >= 0 && g.b < int32_t(dy) && sieveArray[g.a][g.b])
+      if (g.a >= 0 && g.a < int32_t(dx) && g.b >= 0 && g.b < int32_t(dy) && sieveArray.test(g.a, g.b))
       {
         currentComponent.push_back(g);
         toExplore.push_back(g);
@@ -318,7 +436,7 @@ void BlockMoat::exploreAllComponents()
   {
     for (uint32_t b = 0; b < dy; b++)
     {
-      if (sieveArray[a][b])
+      if (sieveArray.test(a, b))
       {
         gint g(a, b);
         exploreComponent(g);
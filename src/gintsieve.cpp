@@ -4,6 +4,13 @@
 #include "BlockSieve.hpp"
 #include "BlockDonutSieve.hpp"
 #include "SectorSieve.hpp"
+#include "SectorDonutSieve.hpp"
+#include "SegmentedDonutSieve.hpp"
+#include "PrimeCounting.hpp"
+#include "CornacchiaSieve.hpp"
+#include "AnnulusSieve.hpp"
+#include "AnnulusDonutSieve.hpp"
+#include "SmallPrimes.hpp"
 using namespace std;
 
 int main(int argc, const char *argv[])
@@ -21,10 +28,16 @@ int main(int argc, const char *argv[])
   bool printArray = false;
   bool write = false;
   bool count = false;
+  bool unsorted = false;
   bool donut = false;
   bool octant = false;
   bool block = false;
   bool sector = false;
+  bool segmented = false;
+  bool rational = false;
+  bool cornacchia = false;
+  bool annulus = false;
+  uint32_t threads = 1;
 
   uint64_t x = 0;
   uint64_t y = 0;
@@ -43,18 +56,25 @@ int main(int argc, const char *argv[])
       cerr << "Usage: " << argv[0] << " x [y dx dy alpha beta] [option1] [option2] ...\n"
            << "Generate Gaussian primes with norm up to x using sieving methods.\n"
            << "    x                   Norm-bound of the generated primes\n"
-           << "    y                   Coordinates (x, y) of SW-corner of array in block sieve mode.\n"
+           << "    y                   Coordinates (x, y) of SW-corner of array in block sieve mode,\n"
+           << "                        or outer norm-bound in annulus sieve mode.\n"
            << "    dx                  Horizontal side length in block sieve mode.\n"
            << "    dy                  Vertical side length in block sieve mode.\n"
            << "    alpha               Start angle in sector sieve mode.\n"
-           << "    beta                Terminal angle in sector sieve mode.\n\n"
+           << "    beta                Terminal angle in sector sieve mode.\n"
+           << "    alpha, beta         Optional window of angles in annulus sieve mode.\n\n"
            << "Options:\n"
            << "    -h, --help          Print this help message.\n"
            << "    -v, --verbose       Display sieving progress.\n"
            << "    -p, --printprimes   Print the real and imag part of primes found by the sieve.\n"
            << "    -w, --write         Write primes to csv file in current directory.\n"
            << "    -a, --printarray    Print a text representation of the sieve array.\n"
-           << "    -c, --count         Count the number of generated primes and exit program.\n\n"
+           << "    -c, --count         Count the number of generated primes and exit program.\n"
+           << "    -r, --rational      Count primes up to norm x without sieving, by counting rational\n"
+           << "                        primes 1 mod 4 up to x and 3 mod 4 up to sqrt(x); implies\n"
+           << "                        --count. Much faster than any sieve for large x.\n"
+           << "    -u, --unsorted      Stream primes in sieve order as they are found instead of\n"
+           << "                        sorting them by norm; primes are never all held in memory.\n\n"
            << "Optional sieve types:\n"
            << "    -o, --octant        Sieve array indexed by Gaussian integers in the first octant.\n"
            << "                        This is the default sieve method called.\n"
@@ -62,10 +82,30 @@ int main(int argc, const char *argv[])
            << "                        with start angle alpha and final angle beta.\n"
            << "    -b, --block         Sieve array indexed by Gaussian integers in the rectangle\n"
            << "                        defined by x <= real < x + dx and y <= imag < y + dy.\n"
+           << "    --annulus           Sieve array indexed by Gaussian integers in the first octant\n"
+           << "                        with norm between x and y, leaving out the disk inside. With\n"
+           << "                        angles alpha and beta, the first quadrant with alpha <= arg\n"
+           << "                        < beta is sieved instead.\n"
            << "    -d, --donut         If a donut version of the sieve array exists, use it. In the\n"
            << "                        donut sieve, the sieve array consists of Gaussian integers\n"
-           << "                        coprime to 2 and 5. This option can be used with --octant\n"
-           << "                        and --block, and is often significantly faster.\n"
+           << "                        coprime to 2 and 5. This option can be used with --octant,\n"
+           << "                        --sector, --block and --annulus, and is often significantly\n"
+           << "                        faster.\n"
+           << "    --segmented         Sieve the donut array of the first octant one cache-sized\n"
+           << "                        tile at a time. Memory use is proportional to sqrt(x) rather\n"
+           << "                        than x, so much larger norm bounds can be reached.\n"
+           << "    --cornacchia        Sieve the rational integers 1 mod 4 up to x in segments and\n"
+           << "                        split each rational prime found as a sum of two squares.\n"
+           << "                        Primes come out in order of norm, so --unsorted costs nothing.\n"
+           << "    --threads=N         Sieve strips of tiles on N threads in parallel; implies\n"
+           << "                        --segmented unless --cornacchia is given, in which case\n"
+           << "                        segments are sieved in parallel. With --sector, implies\n"
+           << "                        --donut and sieves annular pieces of the sector in\n"
+           << "                        parallel. Use N = 0 for every hardware thread.\n"
+           << "    --cache=PATH        Keep the small primes used for sieving in the file PATH, and\n"
+           << "                        read them from it instead of sieving them when it reaches\n"
+           << "                        far enough. The environment variable GINT_PRIMES_CACHE is\n"
+           << "                        used when this option is not given.\n"
            << endl;
       return 1;
     }
@@ -91,6 +131,14 @@ int main(int argc, const char *argv[])
     {
       count = true;
     }
+    if ((arg == "-r") || (arg == "--rational"))
+    {
+      rational = true;
+    }
+    if ((arg == "-u") || (arg == "--unsorted"))
+    {
+      unsorted = true;
+    }
     if ((arg == "-d") || (arg == "--donut"))
     {
       donut = true;
@@ -107,6 +155,26 @@ int main(int argc, const char *argv[])
     {
       block = true;
     }
+    if (arg == "--segmented")
+    {
+      segmented = true;
+    }
+    if (arg == "--cornacchia")
+    {
+      cornacchia = true;
+    }
+    if (arg == "--annulus")
+    {
+      annulus = true;
+    }
+    if (arg.compare(0, 10, "--threads=") == 0)
+    {
+      threads = stoul(arg.substr(10));
+    }
+    if (arg.compare(0, 8, "--cache=") == 0)
+    {
+      SmallPrimes::setCacheFile(arg.substr(8));
+    }
 
     // Getting the input if it is a decimal type number.
     if ((arg.front() == '0') || (arg.front() == '.'))
@@ -153,10 +221,26 @@ int main(int argc, const char *argv[])
   }
   else
   {
-    if (sector)
+    if (sector && (donut || (threads != 1)))
+    {
+      sieveType = "sectorDonut";
+    }
+    else if (sector)
     {
       sieveType = "sector";
     }
+    else if (annulus && (alpha != -1.0))
+    {
+      sieveType = "annulusWindow";
+    }
+    else if (annulus && donut)
+    {
+      sieveType = "annulusDonut";
+    }
+    else if (annulus)
+    {
+      sieveType = "annulus";
+    }
     else if (block && donut)
     {
       sieveType = "blockDonut";
@@ -165,6 +249,14 @@ int main(int argc, const char *argv[])
     {
       sieveType = "block";
     }
+    else if (cornacchia)
+    {
+      sieveType = "cornacchia";
+    }
+    else if (segmented || (threads != 1))
+    {
+      sieveType = "segmented";
+    }
     else if (octant && !donut)
     {
       sieveType = "octant";
@@ -176,6 +268,19 @@ int main(int argc, const char *argv[])
     cerr << '\n'
          << endl;
   }
+  // Counting without a sieve.
+  if (rational)
+  {
+    if (sector || block || annulus)
+    {
+      cerr << "Rational prime counting only counts primes up to a norm bound.\n"
+           << "Use -h optional flag for help.\n"
+           << endl;
+      return 1;
+    }
+    cout << countGPrimesToNorm(x) << endl;
+    return 0;
+  }
   // Very boilerplate, but sieve objects are distinct.
   if (sieveType == "octantDonut")
   {
@@ -195,16 +300,49 @@ int main(int argc, const char *argv[])
       cout << s.getCountBigPrimes() << endl;
       return 0; // early exit for count
     }
-    s.setBigPrimes();
-    s.sortBigPrimes();
-    if (write)
+    // Printing is the default behavior if no useful options are passed in.
+    s.outputBigPrimes(!unsorted, printPrimes || ((!printArray) && (!write)), write);
+  }
+  else if (sieveType == "segmented")
+  {
+    if (verbose)
     {
-      s.writeBigPrimesToFile();
+      cerr << "\nCalling the Segmented Donut Sieve.\n"
+           << endl;
     }
-    // Default behavior if no useful options passed in.
-    if (printPrimes || ((!printPrimes) && (!printArray) && (!write)))
+    SegmentedDonutSieve s(x, verbose, threads);
+    s.run();
+    if (count)
+    {
+      cout << s.getCountBigPrimes() << endl;
+      return 0; // early exit for count
+    }
+    // Printing is the default behavior if no useful options are passed in.
+    s.outputBigPrimes(!unsorted, printPrimes || ((!printArray) && (!write)), write);
+    if (printArray)
     {
-      s.printBigPrimes();
+      s.printSieveArray(); // only the final tile remains
+    }
+  }
+  else if (sieveType == "cornacchia")
+  {
+    if (verbose)
+    {
+      cerr << "\nCalling the Cornacchia Sieve.\n"
+           << endl;
+    }
+    CornacchiaSieve s(x, verbose, threads);
+    s.run();
+    if (count)
+    {
+      cout << s.getCountBigPrimes() << endl;
+      return 0; // early exit for count
+    }
+    // Printing is the default behavior if no useful options are passed in.
+    s.outputBigPrimes(!unsorted, printPrimes || ((!printArray) && (!write)), write);
+    if (printArray)
+    {
+      s.printSieveArray(); // only the final segment remains
     }
   }
   else if (sieveType == "octant")
@@ -225,22 +363,38 @@ int main(int argc, const char *argv[])
       cout << s.getCountBigPrimes() << endl;
       return 0; // early exit for count
     }
-    else
+    // Printing is the default behavior if no useful options are passed in.
+    s.outputBigPrimes(!unsorted, printPrimes || ((!printArray) && (!write)), write);
+  }
+  else if (sieveType == "sector")
+  {
+    if ((alpha == -1.0) || (beta == -1.0))
     {
-      s.setBigPrimes();
-      s.sortBigPrimes();
+      cerr << "Provide angle values to use sector sieve.\n"
+           << "Use -h optional flag for help.\n"
+           << endl;
+      return 1;
     }
-    if (write)
+    if (verbose)
     {
-      s.writeBigPrimesToFile();
+      cerr << "\nCalling the Sector Sieve.\n"
+           << endl;
     }
-    // Default behavior if no useful options passed in.
-    if (printPrimes || ((!printPrimes) && (!printArray) && (!write)))
+    SectorSieve s(x, alpha, beta, verbose);
+    s.run();
+    if (printArray)
     {
-      s.printBigPrimes();
+      s.printSieveArray();
     }
+    if (count)
+    {
+      cout << s.getCountBigPrimes() << endl;
+      return 0; // early exit for count
+    }
+    // Printing is the default behavior if no useful options are passed in.
+    s.outputBigPrimes(!unsorted, printPrimes || ((!printArray) && (!write)), write);
   }
-  else if (sieveType == "sector")
+  else if (sieveType == "sectorDonut")
   {
     if ((alpha == -1.0) || (beta == -1.0))
     {
@@ -251,10 +405,10 @@ int main(int argc, const char *argv[])
     }
     if (verbose)
     {
-      cerr << "\nCalling the Sector Sieve.\n"
+      cerr << "\nCalling the Sector Donut Sieve.\n"
            << endl;
     }
-    SectorSieve s(x, alpha, beta, verbose);
+    SectorDonutSieve s(x, alpha, beta, verbose, threads);
     s.run();
     if (printArray)
     {
@@ -265,33 +419,52 @@ int main(int argc, const char *argv[])
       cout << s.getCountBigPrimes() << endl;
       return 0; // early exit for count
     }
-    s.setBigPrimes();
-    s.sortBigPrimes();
-    if (write)
+    // Printing is the default behavior if no useful options are passed in.
+    s.outputBigPrimes(!unsorted, printPrimes || ((!printArray) && (!write)), write);
+  }
+  else if (sieveType == "annulus")
+  {
+    if (!y)
     {
-      s.writeBigPrimesToFile();
+      cerr << "Provide norms x and y to use annulus sieve.\n"
+           << "Use -h optional flag for help.\n"
+           << endl;
+      return 1;
     }
-    // Default behavior if no useful options passed in.
-    if (printPrimes || ((!printPrimes) && (!printArray) && (!write)))
+    if (verbose)
     {
-      s.printBigPrimes();
+      cerr << "\nCalling the Annulus Sieve.\n"
+           << endl;
+    }
+    AnnulusSieve s(x, y, verbose);
+    s.run();
+    if (printArray)
+    {
+      s.printSieveArray();
     }
+    if (count)
+    {
+      cout << s.getCountBigPrimes() << endl;
+      return 0; // early exit for count
+    }
+    // Printing is the default behavior if no useful options are passed in.
+    s.outputBigPrimes(!unsorted, printPrimes || ((!printArray) && (!write)), write);
   }
-  else if (sieveType == "blockDonut")
+  else if (sieveType == "annulusDonut")
   {
-    if (!y || !dx || !dy)
+    if (!y)
     {
-      cerr << "Provide coordinates x, y, dx, and dy to use block sieve.\n"
+      cerr << "Provide norms x and y to use annulus sieve.\n"
            << "Use -h optional flag for help.\n"
            << endl;
       return 1;
     }
     if (verbose)
     {
-      cerr << "\nCalling the Block Donut Sieve.\n"
+      cerr << "\nCalling the Annulus Donut Sieve.\n"
            << endl;
     }
-    BlockDonutSieve s(x, y, dx, dy);
+    AnnulusDonutSieve s(x, y, verbose);
     s.run();
     if (printArray)
     {
@@ -302,19 +475,38 @@ int main(int argc, const char *argv[])
       cout << s.getCountBigPrimes() << endl;
       return 0; // early exit for count
     }
-    s.setBigPrimes();
-    s.sortBigPrimes();
-    if (write)
+    // Printing is the default behavior if no useful options are passed in.
+    s.outputBigPrimes(!unsorted, printPrimes || ((!printArray) && (!write)), write);
+  }
+  else if (sieveType == "annulusWindow")
+  {
+    if ((!y) || (beta == -1.0))
+    {
+      cerr << "Provide norms x and y and angle values to use annulus sieve with a window.\n"
+           << "Use -h optional flag for help.\n"
+           << endl;
+      return 1;
+    }
+    if (verbose)
+    {
+      cerr << "\nCalling the Annulus Sieve with a window.\n"
+           << endl;
+    }
+    AnnulusSieve s(x, y, alpha, beta, verbose);
+    s.run();
+    if (printArray)
     {
-      s.writeBigPrimesToFile();
+      s.printSieveArray();
     }
-    // Default behavior if no useful options passed in.
-    if (printPrimes || ((!printPrimes) && (!printArray) && (!write)))
+    if (count)
     {
-      s.printBigPrimes();
+      cout << s.getCountBigPrimes() << endl;
+      return 0; // early exit for count
     }
+    // Printing is the default behavior if no useful options are passed in.
+    s.outputBigPrimes(!unsorted, printPrimes || ((!printArray) && (!write)), write);
   }
-  else if (sieveType == "block")
+  else if (sieveType == "blockDonut")
   {
     if (!y || !dx || !dy)
     {
@@ -325,10 +517,10 @@ int main(int argc, const char *argv[])
     }
     if (verbose)
     {
-      cerr << "\nCalling the Block Sieve.\n"
+      cerr << "\nCalling the Block Donut Sieve.\n"
            << endl;
     }
-    BlockSieve s(x, y, dx, dy, verbose);
+    BlockDonutSieve s(x, y, dx, dy);
     s.run();
     if (printArray)
     {
@@ -339,17 +531,36 @@ int main(int argc, const char *argv[])
       cout << s.getCountBigPrimes() << endl;
       return 0; // early exit for count
     }
-    s.setBigPrimes();
-    s.sortBigPrimes();
-    if (write)
+    // Printing is the default behavior if no useful options are passed in.
+    s.outputBigPrimes(!unsorted, printPrimes || ((!printArray) && (!write)), write);
+  }
+  else if (sieveType == "block")
+  {
+    if (!y || !dx || !dy)
     {
-      s.writeBigPrimesToFile();
+      cerr << "Provide coordinates x, y, dx, and dy to use block sieve.\n"
+           << "Use -h optional flag for help.\n"
+           << endl;
+      return 1;
+    }
+    if (verbose)
+    {
+      cerr << "\nCalling the Block Sieve.\n"
+           << endl;
     }
-    // Default behavior if no useful options passed in.
-    if (printPrimes || ((!printPrimes) && (!printArray) && (!write)))
+    BlockSieve s(x, y, dx, dy, verbose);
+    s.run();
+    if (printArray)
     {
-      s.printBigPrimes();
+      s.printSieveArray();
+    }
+    if (count)
+    {
+      cout << s.getCountBigPrimes() << endl;
+      return 0; // early exit for count
     }
+    // Printing is the default behavior if no useful options are passed in.
+    s.outputBigPrimes(!unsorted, printPrimes || ((!printArray) && (!write)), write);
   }
   return 0;
 }
@@ -1,20 +1,132 @@
 #include <iostream>
+#include <fstream>
+#include <cstdio>
 #include <random>
 #include <assert.h>
+#include <numeric>
+#include <stdexcept>
 #include "OctantSieve.hpp"
 #include "OctantDonutSieve.hpp"
 #include "BlockSieve.hpp"
 #include "BlockDonutSieve.hpp"
+#include "BlockBatch.hpp"
 #include "SectorSieve.hpp"
+#include "SectorDonutSieve.hpp"
+#include "SegmentedDonutSieve.hpp"
+#include "OctantWheelSieve.hpp"
+#include "NormSort.hpp"
+#include "AnnulusSieve.hpp"
+#include "AnnulusDonutSieve.hpp"
+#include "NormOrderedPrimes.hpp"
+#include "PrimeStream.hpp"
+#include "PrimeCounting.hpp"
+#include "CornacchiaSieve.hpp"
+#include "SmallPrimes.hpp"
+#include "AngularHistogram.hpp"
+#include "SectorRaces.hpp"
 #include "Moat.hpp"
 using namespace std;
 
 int main()
 {
-  cout << "\n#### Testing and timing OctantSieve and OctantDonutSieve\n"
+  // Run first, while the shared table of small primes is still empty.
+  cout << "\n#### Testing and timing SmallPrimes against OctantSieve\n"
        << endl;
-  cout << " | norm bound | # of primes including associates | OctantSieve time | OctantDonutSieve time | " << endl;
-  cout << " |------------|----------------------------------|-------------------|-------------------------| " << endl;
+  cout << " | norm bound | # of primes | OctantSieve time | SmallPrimes time | " << endl;
+  cout << " |------------|-------------|------------------|------------------| " << endl;
+
+  for (int j = 4; j <= 16; j += 2)
+  {
+    auto startTime = chrono::high_resolution_clock::now();
+    OctantSieve o(pow(3, j), false);
+    o.run();
+    vector<gint> oP = o.getBigPrimes();
+    auto endTime = chrono::high_resolution_clock::now();
+    auto totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double octantTime = double(totalTime.count()) / 1000.0;
+
+    // The table grows by sieving the annulus beyond its previous bound.
+    startTime = chrono::high_resolution_clock::now();
+    SmallPrimes::View p = SmallPrimes::upTo(pow(3, j));
+    endTime = chrono::high_resolution_clock::now();
+    totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double tableTime = double(totalTime.count()) / 1000.0;
+
+    cout << " | 3^" << j
+         << " | " << p.size()
+         << " | " << octantTime
+         << " s | " << tableTime
+         << " s | " << endl;
+    assert(p.toVector() == oP);
+  }
+  // Views cut from a smaller table are left as they were.
+  {
+    SmallPrimes::View p = SmallPrimes::upTo(1000);
+    OctantSieve o(1000, false);
+    o.run();
+    SmallPrimes::upTo(SmallPrimes::getBound() + 1);
+    assert(p.toVector() == o.getBigPrimes());
+  }
+  // A cache file written as described in the README is mapped in place of
+  // sieving, and is rewritten once the table grows past it.
+  {
+    OctantSieve o(pow(3, 18), false);
+    o.run();
+    vector<gint> oP = o.getBigPrimes();
+    string path = "ginttest_primes.cache";
+    ofstream f(path, ios::binary);
+    uint32_t version = 1, gintSize = sizeof(gint);
+    uint64_t bound = pow(3, 18), count = oP.size();
+    f.write("GINTPRM", 8);
+    f.write(reinterpret_cast<char *>(&version), 4);
+    f.write(reinterpret_cast<char *>(&gintSize), 4);
+    f.write(reinterpret_cast<char *>(&bound), 8);
+    f.write(reinterpret_cast<char *>(&count), 8);
+    f.write(reinterpret_cast<const char *>(oP.data()), count * sizeof(gint));
+    f.close();
+
+    SmallPrimes::setCacheFile(path);
+    auto startTime = chrono::high_resolution_clock::now();
+    SmallPrimes::View p = SmallPrimes::upTo(pow(3, 18));
+    auto endTime = chrono::high_resolution_clock::now();
+    auto totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    cout << "\nMapped " << p.size() << " primes to norm 3^18 from a cache file in "
+         << double(totalTime.count()) / 1000.0 << " s" << endl;
+    assert(SmallPrimes::getBound() == bound);
+    assert(p.toVector() == oP);
+
+    SmallPrimes::upTo(bound + 1);
+    ifstream g(path, ios::binary);
+    g.seekg(16);
+    g.read(reinterpret_cast<char *>(&bound), 8);
+    g.read(reinterpret_cast<char *>(&count), 8);
+    g.close();
+    assert(bound == SmallPrimes::getBound());
+    assert(count == SmallPrimes::upTo(bound).size());
+    SmallPrimes::setCacheFile("");
+    remove(path.c_str());
+
+    // A cache file given to one sieve is written for it alone.
+    uint64_t x = pow(3, 20);
+    OctantDonutSieve s(x, false);
+    s.setSmallPrimesFromFile(path);
+    auto cachedBound = [&]() {
+      ifstream h(path, ios::binary);
+      h.seekg(16);
+      h.read(reinterpret_cast<char *>(&bound), 8);
+      return bound;
+    };
+    assert(cachedBound() == isqrt(x));
+    SmallPrimes::upTo(SmallPrimes::getBound() + 1);
+    assert(cachedBound() == isqrt(x));
+    assert(SmallPrimes::fromFile(path, isqrt(x)).toVector() == SmallPrimes::upTo(isqrt(x)).toVector());
+    remove(path.c_str());
+  }
+
+  cout << "\n#### Testing and timing OctantSieve, OctantDonutSieve, and SegmentedDonutSieve\n"
+       << endl;
+  cout << " | norm bound | # of primes including associates | OctantSieve time | OctantDonutSieve time | SegmentedDonutSieve time | " << endl;
+  cout << " |------------|----------------------------------|-------------------|-------------------------|----------------------------| " << endl;
 
   for (int j = 20; j <= 30; j++)
   {
@@ -34,16 +146,478 @@ int main()
     totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
     double donutTime = double(totalTime.count()) / 1000.0;
 
+    startTime = chrono::high_resolution_clock::now();
+    SegmentedDonutSieve t(pow(2, j), false);
+    t.run();
+    vector<gint> tP = t.getBigPrimes(false); // not sorting yet
+    endTime = chrono::high_resolution_clock::now();
+    totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double segmentedTime = double(totalTime.count()) / 1000.0;
+
     cout << " | 2^" << j
          << " | " << 4 * oP.size()
          << " | " << octantTime
          << " s | " << donutTime
+         << " s | " << segmentedTime
          << " s | " << endl;
 
-    // Sorting generated primes and checking if two lists are equal. This takes a long time.
+    // Sorting generated primes and checking if the lists are equal. This takes a long time.
     sort(oP.begin(), oP.end());
     sort(dP.begin(), dP.end());
+    sort(tP.begin(), tP.end());
     assert(oP == dP);
+    assert(oP == tP);
+
+    // Many small tiles shared among threads should give the same primes.
+    SegmentedDonutSieve u(pow(2, j), false, 4, 7);
+    u.run();
+    if (j <= 24)
+    {
+      assert(u.getBigPrimes() == oP);
+      // Streaming the primes in chunks must visit each of them exactly once.
+      uint64_t streamed = 0;
+      u.visitBigPrimes([&](const vector<gint> &primes) {
+        assert(primes.size() <= PrimeSink::chunkSize);
+        streamed += primes.size();
+      });
+      assert(streamed == oP.size());
+    }
+    else
+    {
+      assert(u.getCountBigPrimes() == 4 * oP.size());
+    }
+  }
+
+  cout << "\n#### Timing donut sieves with wheels of modulus 10, 30, and 130\n"
+       << endl;
+  cout << " | norm bound | # of primes including associates | modulus 10 time | modulus 30 time | modulus 130 time | " << endl;
+  cout << " |------------|----------------------------------|-----------------|-----------------|------------------| " << endl;
+
+  for (int j = 20; j <= 30; j += 2)
+  {
+    auto startTime = chrono::high_resolution_clock::now();
+    OctantDonutSieve d(pow(2, j), false);
+    d.run();
+    uint64_t count10 = d.getCountBigPrimes();
+    auto endTime = chrono::high_resolution_clock::now();
+    auto totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double time10 = double(totalTime.count()) / 1000.0;
+
+    startTime = chrono::high_resolution_clock::now();
+    OctantWheelSieve<30> w(pow(2, j), false);
+    w.run();
+    uint64_t count30 = w.getCountBigPrimes();
+    endTime = chrono::high_resolution_clock::now();
+    totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double time30 = double(totalTime.count()) / 1000.0;
+
+    startTime = chrono::high_resolution_clock::now();
+    OctantWheelSieve<130> v(pow(2, j), false);
+    v.run();
+    uint64_t count130 = v.getCountBigPrimes();
+    endTime = chrono::high_resolution_clock::now();
+    totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double time130 = double(totalTime.count()) / 1000.0;
+
+    cout << " | 2^" << j
+         << " | " << count10
+         << " | " << time10
+         << " s | " << time30
+         << " s | " << time130
+         << " s | " << endl;
+
+    assert(count10 == count30);
+    assert(count10 == count130);
+    if (j <= 24)
+    { // the wheel primes dividing 30 and 130 must also be gathered
+      vector<gint> dP = d.getBigPrimes();
+      assert(dP == w.getBigPrimes());
+      assert(dP == v.getBigPrimes());
+    }
+  }
+
+  cout << "\n#### Timing std::sort and radixSortByNorm on the primes of the first quadrant\n"
+       << endl;
+  cout << " | norm bound | # of primes | std::sort time | radixSortByNorm time | " << endl;
+  cout << " |------------|-------------|----------------|----------------------| " << endl;
+
+  for (int j = 20; j <= 30; j += 2)
+  {
+    OctantDonutSieve d(pow(2, j), false);
+    d.run();
+    vector<gint> sP = d.getBigPrimes(false);
+    vector<gint> rP = sP;
+
+    auto startTime = chrono::high_resolution_clock::now();
+    sort(sP.begin(), sP.end());
+    auto endTime = chrono::high_resolution_clock::now();
+    auto totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double stdTime = double(totalTime.count()) / 1000.0;
+
+    startTime = chrono::high_resolution_clock::now();
+    radixSortByNorm(rP);
+    endTime = chrono::high_resolution_clock::now();
+    totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double radixTime = double(totalTime.count()) / 1000.0;
+
+    cout << " | 2^" << j
+         << " | " << sP.size()
+         << " | " << stdTime
+         << " s | " << radixTime
+         << " s | " << endl;
+    assert(sP == rP);
+  }
+
+  // Arbitrary gints in the upper half plane, with many ties in norm. Below the
+  // real axis, a + bi and a - bi are equivalent under operator<, so their order
+  // after std::sort is unspecified.
+  {
+    mt19937 gen(2020);
+    uniform_int_distribution<int32_t> distReal(-1000, 1000);
+    uniform_int_distribution<int32_t> distImag(0, 1000);
+    vector<gint> sP;
+    for (int i = 0; i < 300000; i++)
+    {
+      sP.emplace_back(distReal(gen), distImag(gen));
+    }
+    vector<gint> rP = sP;
+    sort(sP.begin(), sP.end());
+    radixSortByNorm(rP, 3);
+    assert(sP == rP);
+  }
+
+  cout << "\n#### Testing and timing NormOrderedPrimes in annuli of various widths\n"
+       << endl;
+  cout << " | norm bound | annulus width | # of primes | OctantDonutSieve and sort time | NormOrderedPrimes time | " << endl;
+  cout << " |------------|---------------|-------------|--------------------------------|------------------------| " << endl;
+
+  for (int j = 20; j <= 26; j += 2)
+  {
+    auto startTime = chrono::high_resolution_clock::now();
+    OctantDonutSieve d(pow(2, j), false);
+    d.run();
+    vector<gint> dP = d.getBigPrimes(true, true);
+    auto endTime = chrono::high_resolution_clock::now();
+    auto totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double donutTime = double(totalTime.count()) / 1000.0;
+
+    for (int k = j - 8; k <= j; k += 4)
+    {
+      startTime = chrono::high_resolution_clock::now();
+      NormOrderedPrimes primes(0, uint64_t(1) << k);
+      uint64_t i = 0;
+      for (gint g : primes)
+      {
+        if (g.norm() > dP.back().norm())
+        {
+          break;
+        }
+        assert(g == dP[i]);
+        i++;
+      }
+      assert(i == dP.size());
+      endTime = chrono::high_resolution_clock::now();
+      totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+      double iteratorTime = double(totalTime.count()) / 1000.0;
+
+      cout << " | 2^" << j
+           << " | 2^" << k
+           << " | " << dP.size()
+           << " | " << donutTime
+           << " s | " << iteratorTime
+           << " s | " << endl;
+    }
+
+    // An annulus starting away from the origin holds exactly the primes between its norms.
+    uint64_t x1 = dP[dP.size() / 3].norm();
+    uint64_t x2 = dP[dP.size() / 2].norm();
+    AnnulusSieve a(x1, x2, false);
+    a.run();
+    vector<gint> aP = a.getBigPrimes();
+    vector<gint> between;
+    for (gint g : dP)
+    {
+      if ((x1 <= g.norm()) && (g.norm() <= x2))
+      {
+        between.push_back(g);
+      }
+    }
+    assert(aP == between);
+    assert(a.getCountBigPrimes() == 4 * aP.size());
+  }
+
+  cout << "\n#### Testing and timing PrimeStream against OctantDonutSieve\n"
+       << endl;
+  cout << " | norm bound | chunk size | # of primes | OctantDonutSieve time | PrimeStream time | " << endl;
+  cout << " |------------|------------|-------------|-----------------------|------------------| " << endl;
+
+  for (int j = 20; j <= 28; j += 4)
+  {
+    auto startTime = chrono::high_resolution_clock::now();
+    OctantDonutSieve d(pow(2, j), false);
+    d.run();
+    vector<gint> dP = d.getBigPrimes(true, true);
+    auto endTime = chrono::high_resolution_clock::now();
+    auto totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double donutTime = double(totalTime.count()) / 1000.0;
+
+    for (int k = 12; k <= 20; k += 8)
+    {
+      startTime = chrono::high_resolution_clock::now();
+      uint64_t x = pow(2, j);
+      PrimeStream stream([x](PrimeSink &sink) {
+        SegmentedDonutSieve s(x, false, 1);
+        s.run();
+        s.harvestBigPrimes(sink);
+      }, 1 << k);
+      vector<gint> sP;
+      for (vector<gint> chunk = stream.next(); !chunk.empty(); chunk = stream.next())
+      {
+        // Only the last chunk is short.
+        assert(sP.size() % (1 << k) == 0);
+        sP.insert(sP.end(), chunk.begin(), chunk.end());
+      }
+      endTime = chrono::high_resolution_clock::now();
+      totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+      double streamTime = double(totalTime.count()) / 1000.0;
+      radixSortByNorm(sP);
+      assert(sP == dP);
+
+      cout << " | 2^" << j
+           << " | 2^" << k
+           << " | " << dP.size()
+           << " | " << donutTime
+           << " s | " << streamTime
+           << " s | " << endl;
+    }
+  }
+  // A stream dropped after its first chunk stops its producer there, and an
+  // exception thrown by the harvest comes out of next().
+  {
+    auto startTime = chrono::high_resolution_clock::now();
+    {
+      PrimeStream stream([](PrimeSink &sink) {
+        SegmentedDonutSieve s(uint64_t(1) << 40, false, 1);
+        s.run();
+        s.harvestBigPrimes(sink);
+      }, 1000);
+      assert(stream.next().size() == 1000);
+    }
+    auto endTime = chrono::high_resolution_clock::now();
+    auto totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    cout << "\nDropped a stream of primes to norm 2^40 after one chunk in "
+         << double(totalTime.count()) / 1000.0 << " s" << endl;
+
+    PrimeStream failing([](PrimeSink &sink) {
+      sink.push(gint(1, 1));
+      sink.flush();
+      throw invalid_argument("harvest failed");
+    }, 1);
+    assert(failing.next().size() == 1);
+    bool thrown = false;
+    try
+    {
+      failing.next();
+    }
+    catch (invalid_argument &)
+    {
+      thrown = true;
+    }
+    assert(thrown);
+  }
+
+  cout << "\n#### Testing and timing countGPrimesToNorm against SegmentedDonutSieve\n"
+       << endl;
+  cout << " | norm bound | # of primes including associates | SegmentedDonutSieve time | countGPrimesToNorm time | " << endl;
+  cout << " |------------|----------------------------------|--------------------------|-------------------------| " << endl;
+
+  for (int j = 20; j <= 32; j += 2)
+  {
+    auto startTime = chrono::high_resolution_clock::now();
+    SegmentedDonutSieve s(pow(2, j), false);
+    s.run();
+    uint64_t sieveCount = s.getCountBigPrimes();
+    auto endTime = chrono::high_resolution_clock::now();
+    auto totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double sieveTime = double(totalTime.count()) / 1000.0;
+
+    startTime = chrono::high_resolution_clock::now();
+    uint64_t rationalCount = countGPrimesToNorm(pow(2, j));
+    endTime = chrono::high_resolution_clock::now();
+    totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double rationalTime = double(totalTime.count()) / 1000.0;
+
+    cout << " | 2^" << j
+         << " | " << sieveCount
+         << " | " << sieveTime
+         << " s | " << rationalTime
+         << " s | " << endl;
+    assert(sieveCount == rationalCount);
+  }
+
+  // Every small norm bound, including those with no primes or only 1 + i.
+  for (uint64_t x = 0; x < 2000; x++)
+  {
+    uint64_t sieveCount = 0;
+    if (x >= 2)
+    {
+      OctantSieve o(x, false);
+      o.run();
+      sieveCount = o.getCountBigPrimes();
+    }
+    assert(countGPrimesToNorm(x) == sieveCount);
+  }
+  assert(countGPrimesToNorm(1000000000000) == 150431552012); // http://oeis.org/A091100
+
+  cout << "\n#### Testing and timing CornacchiaSieve against OctantDonutSieve\n"
+       << endl;
+  cout << " | norm bound | # of primes | OctantDonutSieve and sort time | CornacchiaSieve time | CornacchiaSieve count time | " << endl;
+  cout << " |------------|-------------|--------------------------------|----------------------|----------------------------| " << endl;
+
+  for (int j = 20; j <= 30; j += 2)
+  {
+    auto startTime = chrono::high_resolution_clock::now();
+    OctantDonutSieve d(pow(2, j), false);
+    d.run();
+    vector<gint> dP = d.getBigPrimes(true, true);
+    auto endTime = chrono::high_resolution_clock::now();
+    auto totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double donutTime = double(totalTime.count()) / 1000.0;
+
+    // Primes come out of the CornacchiaSieve already in order of norm.
+    startTime = chrono::high_resolution_clock::now();
+    CornacchiaSieve c(pow(2, j), false);
+    c.run();
+    vector<gint> cP = c.getBigPrimes(false);
+    endTime = chrono::high_resolution_clock::now();
+    totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double cornacchiaTime = double(totalTime.count()) / 1000.0;
+
+    startTime = chrono::high_resolution_clock::now();
+    uint64_t count = c.getCountBigPrimes();
+    endTime = chrono::high_resolution_clock::now();
+    totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double countTime = double(totalTime.count()) / 1000.0;
+
+    cout << " | 2^" << j
+         << " | " << cP.size()
+         << " | " << donutTime
+         << " s | " << cornacchiaTime
+         << " s | " << countTime
+         << " s | " << endl;
+    assert(cP == dP);
+    assert(count == 4 * dP.size());
+
+    // Many small segments shared among threads should give the same primes.
+    if (j <= 24)
+    {
+      CornacchiaSieve t(pow(2, j), false, 3, 1);
+      t.run();
+      assert(t.getBigPrimes(false) == dP);
+      assert(t.getCountBigPrimes() == count);
+    }
+  }
+
+  // Every small norm bound, with segments of 8192 integers 1 mod 4.
+  for (uint64_t x = 2; x < 500; x++)
+  {
+    OctantSieve o(x, false);
+    o.run();
+    CornacchiaSieve c(x, false, 1, 1);
+    c.run();
+    assert(c.getBigPrimes(false) == o.getBigPrimes());
+  }
+  assert(CornacchiaSieve::splitPrime(1000000000000000009) == gint(1000000000, 3));
+
+  cout << "\n#### Testing and timing AnnulusSieve and AnnulusDonutSieve far from the origin\n"
+       << endl;
+  cout << " | inner norm | outer norm | alpha | beta | # of primes | time | " << endl;
+  cout << " |------------|------------|-------|------|-------------|------| " << endl;
+
+  // Random annuli and annular sectors against the primes of the whole disk.
+  mt19937 gen(13);
+  uniform_real_distribution<long double> distAngle(0.0, M_PI_2);
+  for (int j = 0; j < 100; j++)
+  {
+    uint64_t x2 = 1 + gen() % 2000000;
+    uint64_t x1 = j < 10 ? j : gen() % (x2 + 1);
+    OctantDonutSieve d(x2, false);
+    d.run();
+    vector<gint> between;
+    for (gint g : d.getBigPrimes())
+    {
+      if (g.norm() >= x1)
+      {
+        between.push_back(g);
+      }
+    }
+    AnnulusSieve a(x1, x2, false);
+    a.run();
+    assert(a.getBigPrimes() == between);
+    AnnulusDonutSieve b(x1, x2, false);
+    b.run();
+    assert(b.getBigPrimes() == between);
+    assert(b.getCountBigPrimes() == 4 * between.size());
+
+    long double alpha = distAngle(gen);
+    long double beta = distAngle(gen);
+    if (alpha == beta)
+    {
+      continue;
+    }
+    SectorSieve s(x2, min(alpha, beta), max(alpha, beta), false);
+    s.run();
+    between.clear();
+    for (gint g : s.getBigPrimes())
+    {
+      if (g.norm() >= x1)
+      {
+        between.push_back(g);
+      }
+    }
+    AnnulusSieve w(x1, x2, alpha, beta, false);
+    w.run();
+    assert(w.getBigPrimes() == between);
+    assert(w.getCountBigPrimes() == between.size());
+  }
+
+  // Short intervals of norms; the whole octant only near 10^12, where the
+  // count can be checked against countGPrimesToNorm.
+  for (int j = 12; j <= 15; j++)
+  {
+    uint64_t x1 = pow(10, j);
+    uint64_t x2 = x1 + 100000000;
+    if (j == 12)
+    {
+      auto startTime = chrono::high_resolution_clock::now();
+      AnnulusDonutSieve b(x1, x2, false);
+      b.run();
+      uint64_t count = b.getCountBigPrimes();
+      auto endTime = chrono::high_resolution_clock::now();
+      auto totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+      double donutTime = double(totalTime.count()) / 1000.0;
+
+      cout << " | 10^" << j
+           << " | 10^" << j << " + 10^8"
+           << " | 0 | 2pi | " << count
+           << " | " << donutTime
+           << " s | " << endl;
+      assert(count == countGPrimesToNorm(x2) - countGPrimesToNorm(x1 - 1));
+    }
+
+    auto startTime = chrono::high_resolution_clock::now();
+    AnnulusSieve w(x1, x2, 0.5, 0.51, false);
+    w.run();
+    uint64_t count = w.getCountBigPrimes();
+    auto endTime = chrono::high_resolution_clock::now();
+    auto totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double windowTime = double(totalTime.count()) / 1000.0;
+
+    cout << " | 10^" << j
+         << " | 10^" << j << " + 10^8"
+         << " | 0.5 | 0.51 | " << count
+         << " | " << windowTime
+         << " s | " << endl;
   }
 
   cout << "\n#### Testing and timing BlockSieve and BlockDonutSieve with random rectangles\n"
@@ -90,10 +664,231 @@ int main()
     assert(bP == dP);
   }
 
-  cout << "\n#### Testing and timing SectorSieve with random sectors\n"
+  cout << "\n#### Testing and timing BlockSieve and BlockDonutSieve with thin rectangles\n"
+       << endl;
+  cout << " | block | # of primes | BlockSieve time | BlockDonutSieve time | " << endl;
+  cout << " |-------|-------------|------------------|------------------------| " << endl;
+  for (uint32_t width : {10, 100, 10000, 100000})
+  {
+    // Every block has 10^6 gints; tall ones first, then wide ones.
+    uint32_t x = distInt(rd) * pow(10, 7);
+    uint32_t y = distInt(rd) * pow(10, 7);
+    uint32_t dx = width;
+    uint32_t dy = 1000000 / width;
+
+    auto startTime = chrono::high_resolution_clock::now();
+    BlockSieve b(x, y, dx, dy, false);
+    b.run();
+    vector<gint> bP = b.getBigPrimes(false); // not sorting yet
+    auto endTime = chrono::high_resolution_clock::now();
+    auto totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double blockTime = double(totalTime.count()) / 1000.0;
+
+    startTime = chrono::high_resolution_clock::now();
+    BlockDonutSieve d(x, y, dx, dy, false);
+    d.run();
+    vector<gint> dP = d.getBigPrimes(false); // not sorting yet
+    endTime = chrono::high_resolution_clock::now();
+    totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double donutTime = double(totalTime.count()) / 1000.0;
+
+    cout << " | [" << x << ", " << x + dx
+         << ") x [" << y << ", " << y + dy
+         << ") | " << bP.size()
+         << " | " << blockTime
+         << " s | " << donutTime
+         << " s | " << endl;
+
+    sort(bP.begin(), bP.end());
+    sort(dP.begin(), dP.end());
+    assert(bP == dP);
+  }
+
+  cout << "\n#### Testing and timing BlockSieve and BlockDonutSieve with tall blocks sieved in bands\n"
+       << endl;
+  cout << " | block | # of primes | BlockSieve time | BlockDonutSieve time | " << endl;
+  cout << " |-------|-------------|------------------|------------------------| " << endl;
+  // The shapes of the blocks of VerticalMoat, and of SegmentedMoat near 10^6.
+  for (vector<uint32_t> block : {vector<uint32_t>{uint32_t(distInt(rd) * pow(10, 8)), uint32_t(distInt(rd) * pow(10, 8)), 1000, 10000},
+                                 vector<uint32_t>{1000000, 0, 100, 1000100}})
+  {
+    uint32_t x = block[0];
+    uint32_t y = block[1];
+    uint32_t dx = block[2];
+    uint32_t dy = block[3];
+
+    auto startTime = chrono::high_resolution_clock::now();
+    BlockSieve b(x, y, dx, dy, false);
+    b.run();
+    vector<gint> bP = b.getBigPrimes(false); // not sorting yet
+    auto endTime = chrono::high_resolution_clock::now();
+    auto totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double blockTime = double(totalTime.count()) / 1000.0;
+
+    startTime = chrono::high_resolution_clock::now();
+    BlockDonutSieve d(x, y, dx, dy, false);
+    d.run();
+    vector<gint> dP = d.getBigPrimes(false); // not sorting yet
+    endTime = chrono::high_resolution_clock::now();
+    totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double donutTime = double(totalTime.count()) / 1000.0;
+
+    cout << " | [" << x << ", " << x + dx
+         << ") x [" << y << ", " << y + dy
+         << ") | " << bP.size()
+         << " | " << blockTime
+         << " s | " << donutTime
+         << " s | " << endl;
+
+    sort(bP.begin(), bP.end());
+    sort(dP.begin(), dP.end());
+    assert(bP == dP);
+  }
+
+  cout << "\n#### Testing and timing BlockBatch against one BlockSieve per block\n"
+       << endl;
+  cout << " | grid of blocks | # of primes | BlockSieve time | BlockBatch time | 4 threads | " << endl;
+  cout << " |----------------|-------------|-----------------|-----------------|-----------| " << endl;
+  for (uint32_t side : {10, 20, 30})
+  {
+    // A side x side grid of 100 x 100 blocks with corner at (10^6, 10^6).
+    vector<array<uint32_t, 4>> blocks;
+    for (uint32_t i = 0; i < side; i++)
+    {
+      for (uint32_t j = 0; j < side; j++)
+      {
+        blocks.push_back({1000000 + 100 * i, 1000000 + 100 * j, 100, 100});
+      }
+    }
+
+    auto startTime = chrono::high_resolution_clock::now();
+    vector<uint64_t> blockCounts;
+    for (const array<uint32_t, 4> &block : blocks)
+    {
+      BlockSieve b(block[0], block[1], block[2], block[3], false);
+      b.run();
+      blockCounts.push_back(b.getCountBigPrimes());
+    }
+    auto endTime = chrono::high_resolution_clock::now();
+    auto totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double blockTime = double(totalTime.count()) / 1000.0;
+
+    startTime = chrono::high_resolution_clock::now();
+    BlockBatch batch(blocks, false);
+    vector<uint64_t> batchCounts = batch.getCounts();
+    endTime = chrono::high_resolution_clock::now();
+    totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double batchTime = double(totalTime.count()) / 1000.0;
+
+    startTime = chrono::high_resolution_clock::now();
+    BlockBatch threadedBatch(blocks, false, 4);
+    vector<vector<gint>> batchPrimes = threadedBatch.getBigPrimes(false);
+    endTime = chrono::high_resolution_clock::now();
+    totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double threadedTime = double(totalTime.count()) / 1000.0;
+
+    assert(blockCounts == batchCounts);
+    for (uint32_t k = 0; k < blocks.size(); k++)
+    {
+      assert(batchPrimes[k].size() == batchCounts[k]);
+    }
+    cout << " | " << side << " x " << side
+         << " | " << accumulate(batchCounts.begin(), batchCounts.end(), uint64_t(0))
+         << " | " << blockTime
+         << " s | " << batchTime
+         << " s | " << threadedTime
+         << " s | " << endl;
+  }
+
+  cout << "\n#### Testing and timing AngularHistogram against binning OctantDonutSieve primes\n"
+       << endl;
+  cout << " | norm bound | # of bins | # of primes | OctantDonutSieve time | AngularHistogram time | 4 threads | " << endl;
+  cout << " |------------|-----------|-------------|-----------------------|-----------------------|-----------| " << endl;
+  for (int j = 6; j <= 9; j++)
+  {
+    uint64_t x = pow(10, j);
+    uint32_t nBins = pow(10, j - 3);
+
+    // Binning by atan2, as angular distributions were computed before, and by
+    // scanning every boundary ray.
+    auto startTime = chrono::high_resolution_clock::now();
+    OctantDonutSieve o(x, false);
+    o.run();
+    vector<uint64_t> atanCounts(nBins, 0);
+    o.visitBigPrimes([&](const vector<gint> &primes) {
+      for (gint g : primes)
+      {
+        if (g.b < g.a)
+        {
+          atanCounts[uint32_t(nBins * g.arg() / M_PI_4)]++;
+        }
+      }
+    });
+    auto endTime = chrono::high_resolution_clock::now();
+    auto totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double octantTime = double(totalTime.count()) / 1000.0;
+    if (j <= 7)
+    {
+      vector<Ray> boundaries;
+      for (uint32_t k = 0; k <= nBins; k++)
+      {
+        boundaries.emplace_back(M_PI_4 * (long double)(k) / nBins);
+      }
+      vector<uint64_t> scanCounts(nBins, 0);
+      o.visitBigPrimes([&](const vector<gint> &primes) {
+        for (gint g : primes)
+        {
+          uint32_t k = 0;
+          while ((k + 1 < nBins) && boundaries[k + 1].isOnOrAbove(g.a, g.b))
+          {
+            k++;
+          }
+          scanCounts[k] += g.b < g.a;
+        }
+      });
+      assert(scanCounts == atanCounts);
+    }
+
+    startTime = chrono::high_resolution_clock::now();
+    AngularHistogram h(0, x, nBins, false);
+    vector<uint64_t> counts = h.getCounts();
+    endTime = chrono::high_resolution_clock::now();
+    totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double histogramTime = double(totalTime.count()) / 1000.0;
+
+    startTime = chrono::high_resolution_clock::now();
+    AngularHistogram threaded(0, x, nBins, false, 4);
+    vector<uint64_t> threadedCounts = threaded.getCounts();
+    endTime = chrono::high_resolution_clock::now();
+    totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double threadedTime = double(totalTime.count()) / 1000.0;
+
+    assert(counts == atanCounts);
+    assert(threadedCounts == atanCounts);
+    cout << " | 10^" << j
+         << " | " << nBins
+         << " | " << accumulate(counts.begin(), counts.end(), uint64_t(0))
+         << " | " << octantTime
+         << " s | " << histogramTime
+         << " s | " << threadedTime
+         << " s | " << endl;
+  }
+  // Windows of norms add up, wherever they are cut.
+  {
+    uint64_t x = 12345678;
+    vector<uint64_t> whole = AngularHistogram(0, x, 97, false).getCounts();
+    vector<uint64_t> inner = AngularHistogram(0, 4321, 97, false).getCounts();
+    vector<uint64_t> outer = AngularHistogram(4322, x, 97, false, 3).getCounts();
+    for (uint32_t k = 0; k < 97; k++)
+    {
+      assert(whole[k] == inner[k] + outer[k]);
+    }
+  }
+
+  cout << "\n#### Testing and timing SectorSieve and SectorDonutSieve with random sectors\n"
        << endl;
-  cout << " | alpha | beta | beta - alpha | norm bound | # of primes | time | " << endl;
-  cout << " |-------|------|--------------|------------|-------------|------| " << endl;
+  cout << " | alpha | beta | beta - alpha | norm bound | # of primes | SectorSieve time | SectorDonutSieve time | " << endl;
+  cout << " |-------|------|--------------|------------|-------------|-------------------|-------------------------| " << endl;
   uniform_real_distribution<long double> distReal(0.0, M_PI_4);
   for (int j = 20; j <= 30; j++)
   {
@@ -114,13 +909,23 @@ int main()
     auto endTime = chrono::high_resolution_clock::now();
     auto totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
     double sectorTime = double(totalTime.count()) / 1000.0;
+
+    startTime = chrono::high_resolution_clock::now();
+    SectorDonutSieve t(x, alpha, beta, false);
+    t.run();
+    vector<gint> tP = t.getBigPrimes(false); // not sorting yet
+    endTime = chrono::high_resolution_clock::now();
+    totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double sectorDonutTime = double(totalTime.count()) / 1000.0;
     cout << " | " << alpha
          << " | " << beta
          << " | " << beta - alpha
          << " | 2^" << j
          << " | " << sP.size()
          << " | " << sectorTime
-         << " | " << endl;
+         << " s | " << sectorDonutTime
+         << " s | " << endl;
+    assert(t.getCountBigPrimes() == sP.size());
 
     OctantDonutSieve d(x, false);
     d.run();
@@ -132,13 +937,42 @@ int main()
     // Sorting generated primes and checking if two lists are equal.
     sort(sP.begin(), sP.end());
     sort(dP.begin(), dP.end());
+    sort(tP.begin(), tP.end());
     assert(sP == dP);
+    assert(tP == dP);
+  }
+
+  // Sectors reaching the axes, and small norm bounds.
+  for (int j = 0; j < 200; j++)
+  {
+    uint64_t x = 1 + gen() % (j < 100 ? 2000 : 1000000);
+    long double alpha = j % 4 == 0 ? 0 : distAngle(gen);
+    long double beta = j % 4 == 1 ? M_PI_2 : distAngle(gen);
+    SectorSieve s(x, alpha, beta, false);
+    s.run();
+    SectorDonutSieve t(x, alpha, beta, false);
+    t.run();
+    vector<gint> sP = s.getBigPrimes();
+    assert(t.getBigPrimes() == sP);
+    assert(t.getCountBigPrimes() == sP.size());
+
+    // Annular pieces, alone and sieved in parallel.
+    SectorDonutSieve p(x, alpha, beta, false, 1 + j % 5);
+    p.run();
+    assert(p.getBigPrimes() == sP);
+    assert(p.getCountBigPrimes() == sP.size());
+    uint64_t x1 = gen() % (x + 1);
+    unique_ptr<SectorDonutSieve> u = SectorDonutSieve::annulus(x1, x, alpha, beta, false);
+    u->run();
+    sP.erase(remove_if(sP.begin(), sP.end(), [&](gint g) { return g.norm() < x1; }), sP.end());
+    assert(u->getBigPrimes() == sP);
+    assert(u->getCountBigPrimes() == sP.size());
   }
 
-  cout << "\n#### Timing SectorSieve with random thin sectors\n"
+  cout << "\n#### Timing SectorSieve and SectorDonutSieve with random thin sectors\n"
        << endl;
-  cout << " | alpha | beta | beta - alpha | norm bound | # of primes | time | " << endl;
-  cout << " |-------|------|--------------|------------|-------------|------| " << endl;
+  cout << " | alpha | beta | beta - alpha | norm bound | # of primes | SectorSieve time | SectorDonutSieve time | 4 threads | " << endl;
+  cout << " |-------|------|--------------|------------|-------------|-------------------|-------------------------|-----------| " << endl;
   for (int j = 30; j <= 40; j++)
   {
     uint64_t x = pow(2, j);
@@ -152,13 +986,131 @@ int main()
     auto endTime = chrono::high_resolution_clock::now();
     auto totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
     double sectorTime = double(totalTime.count()) / 1000.0;
+
+    startTime = chrono::high_resolution_clock::now();
+    SectorDonutSieve t(x, alpha, beta, false);
+    t.run();
+    uint64_t count = t.getCountBigPrimes();
+    endTime = chrono::high_resolution_clock::now();
+    totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double sectorDonutTime = double(totalTime.count()) / 1000.0;
+
+    startTime = chrono::high_resolution_clock::now();
+    SectorDonutSieve p(x, alpha, beta, false, 4);
+    p.run();
+    uint64_t parallelCount = p.getCountBigPrimes();
+    endTime = chrono::high_resolution_clock::now();
+    totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double parallelTime = double(totalTime.count()) / 1000.0;
     cout << " | " << alpha
          << " | " << beta
          << " | 2^" << 20 - j
          << " | 2^" << j
          << " | " << sP.size()
          << " | " << sectorTime
-         << " | " << endl;
+         << " s | " << sectorDonutTime
+         << " s | " << parallelTime
+         << " s | " << endl;
+    assert(count == sP.size());
+    assert(parallelCount == sP.size());
+  }
+
+  cout << "\n#### Testing and timing SectorRaces against one SectorDonutSieve per sector\n"
+       << endl;
+  cout << " | # of races | norm bound | # of bins | SectorDonutSieve time | SectorRaces time | 4 threads | " << endl;
+  cout << " |------------|------------|-----------|-----------------------|------------------|-----------| " << endl;
+  for (uint32_t nRaces : {1, 4, 16})
+  {
+    uint64_t x = pow(10, 8);
+    uint64_t nBins = 1000;
+    // Random races, some sharing an angle so that sectors touch.
+    vector<array<long double, 4>> races;
+    for (uint32_t k = 0; k < nRaces; k++)
+    {
+      long double alpha = distReal(rd), beta = distReal(rd), gamma = distReal(rd);
+      races.push_back({alpha, beta, k % 2 ? beta : gamma, distReal(rd)});
+    }
+
+    // Norm data from the primes of each sector, sieved separately.
+    auto startTime = chrono::high_resolution_clock::now();
+    vector<vector<int64_t>> expected(nRaces, vector<int64_t>(nBins, 0));
+    vector<vector<gint>> expectedPrimes;
+    for (uint32_t j = 0; j < 2 * nRaces; j++)
+    {
+      const array<long double, 4> &race = races[j / 2];
+      SectorDonutSieve t(x, race[j % 2 * 2], race[j % 2 * 2 + 1], false);
+      t.run();
+      t.visitBigPrimes([&](const vector<gint> &primes) {
+        for (gint g : primes)
+        {
+          expected[j / 2][min(g.norm() * nBins / x, nBins - 1)] += j % 2 ? -1 : 1;
+        }
+      });
+      if (nRaces == 1)
+      {
+        expectedPrimes.push_back(t.getBigPrimes());
+      }
+    }
+    for (vector<int64_t> &data : expected)
+    {
+      partial_sum(data.begin(), data.end(), data.begin());
+    }
+    auto endTime = chrono::high_resolution_clock::now();
+    auto totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double sectorDonutTime = double(totalTime.count()) / 1000.0;
+
+    startTime = chrono::high_resolution_clock::now();
+    SectorRaces r(x, nBins, races, nRaces == 1, false);
+    r.run();
+    endTime = chrono::high_resolution_clock::now();
+    totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double racesTime = double(totalTime.count()) / 1000.0;
+
+    startTime = chrono::high_resolution_clock::now();
+    SectorRaces p(x, nBins, races, false, false, 4);
+    p.run();
+    endTime = chrono::high_resolution_clock::now();
+    totalTime = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    double parallelTime = double(totalTime.count()) / 1000.0;
+
+    for (uint32_t k = 0; k < nRaces; k++)
+    {
+      assert(r.getNormData(k) == expected[k]);
+      assert(p.getNormData(k) == expected[k]);
+    }
+    // Primes are kept when asked for, and are those of each sector; taking
+    // them moves them out.
+    if (nRaces == 1)
+    {
+      for (uint32_t j = 0; j < 2; j++)
+      {
+        assert(r.getSectorPrimes(j).size() == expectedPrimes[j].size());
+        vector<gint> primes = r.takeSectorPrimes(j);
+        sort(primes.begin(), primes.end());
+        assert(primes == expectedPrimes[j]);
+        assert(r.getSectorPrimes(j).empty());
+      }
+    }
+    else
+    {
+      bool thrown = false;
+      try
+      {
+        r.getSectorPrimes(0);
+      }
+      catch (invalid_argument &)
+      {
+        thrown = true;
+      }
+      assert(thrown);
+    }
+    cout << " | " << nRaces
+         << " | " << x
+         << " | " << nBins
+         << " | " << sectorDonutTime
+         << " s | " << racesTime
+         << " s | " << parallelTime
+         << " s | " << endl;
   }
 
   cout << "\n#### Testing OctantMoat and SegmentedMoat\n"